@@ -1,13 +1,174 @@
+#include <algorithm>
 #include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 #include "bloom_filter.hpp"
+#include "blocked_bloom_filter.hpp"
+#include "concurrent_bloom_filter.hpp"
+#include "counting_bloom_filter.hpp"
+#include "cuckoo_filter.hpp"
+#include "parallel_bloom_filter.hpp"
+#include "partitioned_bloom_filter.hpp"
 #include "common.hpp"
 
 #define bf_set_size 1000000
 #define bf_fp_prob  1e-09
 #define word_count  1000000
 
-int main() {
+#define cf_word_count 50000
+
+#define large_set_size 1000000000
+#define large_fp_prob  1e-02
+
+#define sweep_query_count 1000000
+
+// bf_bench sweep: one CSV row per filter design, set size and target false
+// positive rate. n distinct keys go in, then the filter is queried with the
+// members and with sweep_query_count keys that are not in the set, which
+// gives the observed false positive rate. benchmarks/words repeats itself
+// past ~55000 words, so the keys are generated instead.
+template <typename filter_type>
+void sweep_row(const char* name, size_t n, double p,
+               const std::vector<std::string>& keys,
+               const std::vector<std::string>& absent) {
+    auto f = filter_type(n, p);
+
+    double add_ns = measure_ns([&](){
+        for (size_t i = 0; i < n; ++i)
+            f.add(keys[i]);
+    });
+
+    size_t hits = 0;
+    double hit_ns = measure_ns([&](){
+        for (size_t i = 0; i < n; ++i)
+            hits += f.test(keys[i]);
+    });
+
+    size_t false_positives = 0;
+    double miss_ns = measure_ns([&](){
+        for (const auto& key : absent)
+            false_positives += f.test(key);
+    });
+
+    std::cout << name << ','
+              << n << ','
+              << p << ','
+              << f.get_hash_func_count() << ','
+              << double(f.get_bit_count()) / n << ','
+              << double(false_positives) / absent.size() << ','
+              << false_positives << ','
+              << add_ns / n << ','
+              << hit_ns / n << ','
+              << miss_ns / absent.size() << ','
+              << (hits == n) << '\n';
+}
+
+void sweep_bench() {
+    std::vector<std::string> keys, absent;
+    for (int i = 0; i < bf_set_size; ++i)
+        keys.push_back(std::to_string(i));
+    for (int i = 0; i < sweep_query_count; ++i)
+        absent.push_back("#" + std::to_string(i));
+
+    std::cout << "filter,n,p,k,bits_per_key,observed_fp_rate,false_positives,"
+                 "add_ns,test_hit_ns,test_miss_ns,no_false_negatives\n";
+
+    for (size_t n : {10000, 100000, 1000000})
+        for (double p : {1e-2, 1e-3, 1e-4}) {
+            sweep_row<bloom_filter<std::string>>("classic", n, p, keys, absent);
+            sweep_row<blocked_bloom_filter<std::string>>("blocked", n, p, keys, absent);
+            sweep_row<partitioned_bloom_filter<std::string>>("partitioned", n, p, keys, absent);
+        }
+}
+
+// bf_bench large [n]: n integer keys, 1e9 by default, into filters with more
+// than 2^32 bits, on regular and on huge pages.
+void large_bench(size_t n) {
+    using large_filter = bloom_filter<uint64_t, XXH3Hasher<uint64_t>>;
+
+    for (auto storage : {bit_storage::heap, bit_storage::huge_pages}) {
+        auto bf = large_filter(n, large_fp_prob, storage);
+
+        std::cout << "Bloom filter"
+                  << (storage == bit_storage::heap ? "" : " on huge pages")
+                  << " n = " << n
+                  << " p = " << large_fp_prob
+                  << " k = " << bf.get_hash_func_count()
+                  << " m = " << bf.get_bit_count() << "\n";
+
+        benchmark_per_op("Insertion ", n, [&](){
+            for (uint64_t i = 0; i < n; ++i)
+                bf.add(i);
+        });
+
+        benchmark_per_op("Testing ", n, [&](){
+            size_t hits = 0;
+            for (uint64_t i = 0; i < n; ++i)
+                hits += bf.test(i);
+            keep(hits);
+        });
+    }
+
+    // an explicit shape past 2^32 bits, which only 64 bit hashes can fill
+    auto bf = large_filter::with_shape(6000000000, 3);
+    for (uint64_t i = 0; i < n; ++i)
+        bf.add(i);
+    bool all = true;
+    for (uint64_t i = 0; i < n; ++i)
+        all = all && bf.test(i);
+    std::cout << "Bloom filter m = " << bf.get_bit_count()
+              << " k = " << bf.get_hash_func_count()
+              << (all ? " finds every key" : " MISSED KEYS") << "\n";
+}
+
+// Cuckoo filters against a bloom filter on the distinct words of
+// benchmarks/words, at the bloom filter's false positive rate.
+void cuckoo_bench(const std::vector<std::string>& words) {
+    auto bf = bloom_filter<std::string>(cf_word_count, bf_fp_prob);
+    auto cf16 = cuckoo_filter<std::string, 16>(cf_word_count);
+    auto cf32 = cuckoo_filter<std::string, 32>(cf_word_count);
+
+    for (int i = 0; i < cf_word_count; ++i) {
+        bf.add(words[i]);
+        cf16.add(words[i]);
+        cf32.add(words[i]);
+    }
+
+    std::cout << "Bloom vs cuckoo @ " << cf_word_count << " words\n"
+              << "Bloom filter p = " << bf_fp_prob << " bits/key = "
+              << double(bf.get_bit_count()) / cf_word_count << "\n"
+              << "Cuckoo filter 16 bit bits/key = " << cf16.get_bits_per_key() << "\n"
+              << "Cuckoo filter 32 bit bits/key = " << cf32.get_bits_per_key() << "\n";
+
+    size_t hits = 0;
+    benchmark_per_op("Bloom filter lookups ", cf_word_count, [&](){
+        for (int i = 0; i < cf_word_count; ++i)
+            hits += bf.test(words[i]);
+    });
+    benchmark_per_op("Cuckoo filter 16 bit lookups ", cf_word_count, [&](){
+        for (int i = 0; i < cf_word_count; ++i)
+            hits += cf16.test(words[i]);
+    });
+    benchmark_per_op("Cuckoo filter 32 bit lookups ", cf_word_count, [&](){
+        for (int i = 0; i < cf_word_count; ++i)
+            hits += cf32.test(words[i]);
+    });
+    keep(hits);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string_view(argv[1]) == "large") {
+        large_bench(argc > 2 ? std::stoull(argv[2]) : large_set_size);
+        return 0;
+    }
+
+    if (argc > 1 && std::string_view(argv[1]) == "sweep") {
+        sweep_bench();
+        return 0;
+    }
+
     auto bf = bloom_filter<std::string>(bf_set_size, bf_fp_prob);
     auto words = read_words(word_count);
 
@@ -24,10 +185,182 @@ int main() {
     });
 
     benchmark("Testing", [&](){
-        bool b = true;
+        size_t hits = 0;
         for(int i = 0; i < word_count; ++i)
-            b = b && bf.test(words[i]);
+            hits += bf.test(words[i]);
+        keep(hits);
     });
 
+    benchmark("Introspection ", [&](){
+        std::cout << "fill = " << bf.get_fill_ratio()
+                  << " n* = " << bf.estimate_cardinality()
+                  << " fp* = " << bf.estimate_fp_rate() << "\n";
+    });
+
+    std::stringstream wire;
+    size_t raw_bytes = (bf.get_bit_count() + 7) / 8;
+    benchmark_per_op("Compressed encode (op = filter byte) ", raw_bytes, [&](){
+        bf.save_compressed(wire);
+    });
+    std::cout << "Compressed size " << wire.str().size() << " bytes, "
+              << 100.0 * wire.str().size() / raw_bytes << "% of raw\n";
+    benchmark_per_op("Compressed decode (op = filter byte) ", raw_bytes, [&](){
+        auto copy = decltype(bf)::load_compressed(wire);
+    });
+
+    auto fnv = bloom_filter<std::string>(bf_set_size, bf_fp_prob);
+    auto xxh3 = bloom_filter<std::string, XXH3Hasher<std::string>>(bf_set_size, bf_fp_prob);
+
+    std::cout << "Hash policies, per key\n";
+
+    benchmark_per_op("Insertion FNV + xxhash32, modulo ", word_count, [&](){
+        for(int i = 0; i < word_count; ++i)
+            fnv.add(words[i]);
+    });
+
+    benchmark_per_op("Testing FNV + xxhash32, modulo ", word_count, [&](){
+        size_t hits = 0;
+        for(int i = 0; i < word_count; ++i)
+            hits += fnv.test(words[i]);
+        keep(hits);
+    });
+
+    benchmark_per_op("Insertion xxhash3 128, multiply-shift ", word_count, [&](){
+        for(int i = 0; i < word_count; ++i)
+            xxh3.add(words[i]);
+    });
+
+    benchmark_per_op("Testing xxhash3 128, multiply-shift ", word_count, [&](){
+        size_t hits = 0;
+        for(int i = 0; i < word_count; ++i)
+            hits += xxh3.test(words[i]);
+        keep(hits);
+    });
+
+    auto batched = bloom_filter<std::string>(bf_set_size, bf_fp_prob);
+
+    benchmark("Batched insertion", [&](){
+        batched.add_many(words.begin(), words.begin() + word_count);
+    });
+
+    benchmark("Batched testing", [&](){
+        auto found = batched.test_many(words.begin(), words.begin() + word_count);
+    });
+
+    auto bbf = blocked_bloom_filter<std::string>(bf_set_size, bf_fp_prob);
+
+    std::cout << "Blocked bloom filter"
+              << " n = " << bf_set_size
+              << " p = " << bf_fp_prob
+              << " k = " << bbf.get_hash_func_count()
+              << " m = " << bbf.get_bit_count()
+              << " fp = " << bbf.get_fp_rate()
+              << " (+" << bbf.get_fp_rate_overhead() << ")"
+              << " @ " << word_count << " words\n";
+
+    benchmark("Insertion", [&](){
+        for(int i = 0; i < word_count; ++i)
+            bbf.add(words[i]);
+    });
+
+    benchmark("Testing", [&](){
+        size_t hits = 0;
+        for(int i = 0; i < word_count; ++i)
+            hits += bbf.test(words[i]);
+        keep(hits);
+    });
+
+    auto cntbf = counting_bloom_filter<std::string>(bf_set_size, bf_fp_prob);
+
+    std::cout << "Counting bloom filter"
+              << " n = " << bf_set_size
+              << " p = " << bf_fp_prob
+              << " k = " << cntbf.get_hash_func_count()
+              << " m = " << cntbf.get_bit_count()
+              << " bytes = " << cntbf.get_memory_usage()
+              << " @ " << word_count << " words\n";
+
+    benchmark("Insertion", [&](){
+        for(int i = 0; i < word_count; ++i)
+            cntbf.add(words[i]);
+    });
+
+    benchmark("Testing", [&](){
+        size_t hits = 0;
+        for(int i = 0; i < word_count; ++i)
+            hits += cntbf.test(words[i]);
+        keep(hits);
+    });
+
+    benchmark("Removal", [&](){
+        for(int i = 0; i < word_count; ++i)
+            cntbf.remove(words[i]);
+    });
+
+    auto pbf = partitioned_bloom_filter<std::string>(bf_set_size, bf_fp_prob);
+
+    std::cout << "Partitioned bloom filter"
+              << " n = " << bf_set_size
+              << " p = " << bf_fp_prob
+              << " k = " << pbf.get_hash_func_count()
+              << " m = " << pbf.get_bit_count()
+              << " @ " << word_count << " words\n";
+
+    benchmark("Insertion", [&](){
+        for(int i = 0; i < word_count; ++i)
+            pbf.add(words[i]);
+    });
+
+    std::cout << "Lookup throughput\n";
+
+    bool found = true;
+    benchmark_per_op("Classic ", word_count, [&](){
+        for(int i = 0; i < word_count; ++i)
+            found = found && bf.test(words[i]);
+    });
+
+    benchmark_per_op("Blocked ", word_count, [&](){
+        for(int i = 0; i < word_count; ++i)
+            found = found && bbf.test(words[i]);
+    });
+
+    benchmark_per_op("Partitioned ", word_count, [&](){
+        for(int i = 0; i < word_count; ++i)
+            found = found && pbf.test(words[i]);
+    });
+
+    cuckoo_bench(words);
+
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "Concurrent bloom filter"
+              << " n = " << bf_set_size
+              << " p = " << bf_fp_prob
+              << " @ " << word_count << " words, 1 to "
+              << max_threads << " threads\n";
+
+    for (unsigned t = 1; t <= max_threads; t *= 2) {
+        auto cbf = concurrent_bloom_filter<std::string>(bf_set_size, bf_fp_prob);
+        auto label = "Insertion " + std::to_string(t) + " threads ";
+        benchmark(label, [&](){
+            std::vector<std::thread> threads;
+            for (unsigned j = 0; j < t; ++j)
+                threads.emplace_back([&, j](){
+                    for (int i = j; i < word_count; i += t)
+                        cbf.add(words[i]);
+                });
+            for (auto& thread : threads)
+                thread.join();
+        });
+    }
+
+    for (unsigned t = 1; t <= max_threads; t *= 2) {
+        auto label = "Parallel build " + std::to_string(t) + " threads ";
+        benchmark(label, [&](){
+            auto pbf = parallel_build<std::string>(bf_set_size, bf_fp_prob,
+                                                   words.begin(), words.begin() + word_count, t);
+        });
+    }
+
     return 0;
-}
\ No newline at end of file
+}
@@ -8,6 +8,10 @@
 #include <functional>
 #include <cassert>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 std::vector<std::string> read_words(int count = 1000000, const char* path = "words") {
     std::ifstream fs(path);
     std::vector<std::string> words;
@@ -35,3 +39,44 @@ void benchmark(std::string_view out, std::function<void()> f) {
               << duration_cast<milliseconds>(t2 - t1).count() << "ms, "
               << duration_cast<seconds>(t2 - t1).count()      << "s\n";
 }
+
+// Wall time of f in nanoseconds, for callers that format their own output.
+double measure_ns(std::function<void()> f) {
+    using namespace std::chrono;
+
+    auto t1 = high_resolution_clock::now();
+    f();
+    auto t2 = high_resolution_clock::now();
+    return duration_cast<nanoseconds>(t2 - t1).count();
+}
+
+// Like benchmark, but reports the time, the throughput and, on x86, the TSC
+// cycles spent per operation.
+void benchmark_per_op(std::string_view out, size_t ops, std::function<void()> f) {
+    using namespace std::chrono;
+
+#if defined(__x86_64__) || defined(__i386__)
+    auto c1 = __rdtsc();
+#endif
+    auto t1 = high_resolution_clock::now();
+    f();
+    auto t2 = high_resolution_clock::now();
+#if defined(__x86_64__) || defined(__i386__)
+    auto c2 = __rdtsc();
+#endif
+
+    double ns = duration_cast<nanoseconds>(t2 - t1).count();
+    std::cout << out
+              << ns / ops << "ns/op, "
+              << ops * 1e3 / ns << " Mops/s";
+#if defined(__x86_64__) || defined(__i386__)
+    std::cout << ", " << double(c2 - c1) / ops << " cycles/op";
+#endif
+    std::cout << "\n";
+}
+
+// Makes value look used, so the compiler cannot drop the loop computing it.
+template <typename T>
+void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
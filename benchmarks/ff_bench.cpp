@@ -0,0 +1,55 @@
+#include <iostream>
+
+#include "bloom_filter.hpp"
+#include "common.hpp"
+#include "fuse_filter.hpp"
+
+#define ff_fp_prob  1e-09
+#define word_count  50000
+#define query_count 1000000
+
+template <typename filter>
+void query_bench(const filter& f, const std::vector<std::string>& words) {
+    bool b = true;
+    benchmark_per_op("Testing ", word_count, [&](){
+        for (int i = 0; i < word_count; ++i)
+            b = b && f.test(words[i]);
+    });
+
+    // "#0", "#1", ... never occur in words
+    int false_positives = 0;
+    for (int i = 0; i < query_count; ++i)
+        false_positives += f.test("#" + std::to_string(i));
+    std::cout << "False positives " << false_positives
+              << " / " << query_count << "\n";
+}
+
+int main() {
+    auto words = read_words(word_count);
+
+    std::cout << "Binary fuse filter 8 bit @ " << word_count << " words\n";
+    fuse_filter<std::string> ff8(words.begin(), words.end());
+    benchmark("Construction ", [&](){
+        fuse_filter<std::string> f(words.begin(), words.end());
+    });
+    std::cout << "bits/key = " << ff8.get_bits_per_key() << "\n";
+    query_bench(ff8, words);
+
+    std::cout << "Binary fuse filter 32 bit @ " << word_count << " words\n";
+    fuse_filter<std::string, uint32_t> ff32(words.begin(), words.end());
+    benchmark("Construction ", [&](){
+        fuse_filter<std::string, uint32_t> f(words.begin(), words.end());
+    });
+    std::cout << "bits/key = " << ff32.get_bits_per_key() << "\n";
+    query_bench(ff32, words);
+
+    std::cout << "Bloom filter p = " << ff_fp_prob << " @ " << word_count << " words\n";
+    auto bf = bloom_filter<std::string>(word_count, ff_fp_prob);
+    benchmark("Construction ", [&](){
+        bf.add_many(words.begin(), words.end());
+    });
+    std::cout << "bits/key = " << double(bf.get_bit_count()) / word_count << "\n";
+    query_bench(bf, words);
+
+    return 0;
+}
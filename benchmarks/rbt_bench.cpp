@@ -1,11 +1,206 @@
+#include <algorithm>
 #include <iostream>
+#include <random>
+#include <string>
+#include <thread>
 
+#include "bloom_set.hpp"
 #include "common.hpp"
+#include "irbt.hpp"
 #include "rbt.hpp"
 
 #define word_count  1000000
+#define set_fp_prob 1e-02
+
+#define compare_word_count 100000
+
+// String comparisons made while searching. legacy_compare costs what the
+// descent did before the comparator policy, a != and then a < per node.
+size_t comparisons = 0;
+
+struct legacy_compare {
+    int operator()(const std::string& a, const std::string& b) const {
+        ++comparisons;
+        if (a == b)
+            return 0;
+        ++comparisons;
+        return a < b ? -1 : 1;
+    }
+};
+
+struct counting_compare {
+    int operator()(const std::string& a, const std::string& b) const {
+        ++comparisons;
+        return a.compare(b);
+    }
+};
+
+template <typename Compare>
+void compare_bench(std::string_view name,
+                   const std::vector<std::string>& words,
+                   const std::vector<std::string>& search_words) {
+    auto rbt = RBTree<std::string, Compare>();
+    for (int i = 0; i < compare_word_count; i++)
+        rbt.insert(words[i]);
+
+    int count = 0;
+    comparisons = 0;
+    benchmark_per_op(name, compare_word_count, [&]() {
+        for (int i = 0; i < compare_word_count; i++)
+            count += rbt.contains(search_words[i]);
+    });
+    std::cout << "Comparisons per search "
+              << double(comparisons) / compare_word_count
+              << ", found " << count << "\n";
+}
+
+// Insert and search on the pointer linked tree and on the index linked one,
+// for integer keys and for the benchmark's words.
+template <typename Tree, typename Key>
+void layout_bench(std::string_view name,
+                  const std::vector<Key>& keys,
+                  const std::vector<Key>& search_keys) {
+    auto tree = Tree();
+    std::cout << name << ", node " << tree.node_size << " bytes\n";
+
+    benchmark_per_op("Insertion ", keys.size(), [&]() {
+        for (const auto& key : keys)
+            tree.insert(key);
+    });
+
+    int count = 0;
+    benchmark_per_op("Search ", search_keys.size(), [&]() {
+        for (const auto& key : search_keys)
+            count += tree.contains(key);
+    });
+    std::cout << "Bytes per node " << double(tree.get_memory_usage()) / tree.size()
+              << ", found " << count << "\n";
+}
+
+void index_bench(const std::vector<std::string>& words,
+                 const std::vector<std::string>& search_words) {
+    std::vector<uint32_t> keys(word_count), search_keys(word_count);
+    std::mt19937 rng(42);
+    for (auto& key : keys)
+        key = rng();
+    for (int i = 0; i < word_count; i++)
+        search_keys[i] = keys[rng() % word_count];
+
+    layout_bench<RBTree<uint32_t>>("Red Black Tree, integers", keys, search_keys);
+    layout_bench<IndexRBTree<uint32_t>>("Index Red Black Tree, integers", keys, search_keys);
+    layout_bench<RBTree<std::string>>("Red Black Tree, words", words, search_words);
+    layout_bench<IndexRBTree<std::string>>("Index Red Black Tree, words", words, search_words);
+}
+
+// Loading a sorted snapshot by repeated insertion against the linear bulk
+// build, on one thread and on all of them.
+void bulk_bench(std::vector<std::string> words) {
+    std::sort(words.begin(), words.end());
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "Sorted load @ " << words.size() << " words\n";
+
+    auto inserted = RBTree<std::string>();
+    benchmark_per_op("Insertion ", words.size(), [&]() {
+        for (const auto& word : words)
+            inserted.insert(word);
+    });
+
+    auto bulk = RBTree<std::string>();
+    benchmark_per_op("assign_sorted ", words.size(), [&]() {
+        bulk.assign_sorted(words.begin(), words.end());
+    });
+
+    std::cout << "assign_sorted, " << threads << " threads ";
+    benchmark_per_op("", words.size(), [&]() {
+        bulk.assign_sorted(words.begin(), words.end(), threads);
+    });
+}
+
+#define scan_count 100000
+#define scan_width 100
+
+// Counting the keys of random ranges of about scan_width keys each, through
+// lower_bound and iteration against copying every key out and scanning.
+void range_bench(const std::vector<std::string>& words) {
+    auto rbt = RBTree<std::string>();
+    rbt.assign_sorted(words.begin(), words.end());
+
+    std::mt19937 rng(42);
+    std::vector<std::pair<std::string, std::string>> ranges;
+    for (int i = 0; i < scan_count; i++) {
+        size_t lo = rng() % (words.size() - scan_width);
+        ranges.emplace_back(words[lo], words[lo + scan_width]);
+    }
+
+    std::cout << "Range scans @ " << scan_count << " ranges of ~"
+              << scan_width << " of " << words.size() << " sorted words\n";
+
+    size_t in_range = 0;
+    benchmark_per_op("count_range ", scan_count, [&]() {
+        for (const auto& [lo, hi] : ranges)
+            in_range += rbt.count_range(lo, hi);
+    });
+    std::cout << "Keys per range " << double(in_range) / scan_count << "\n";
+
+    size_t copied = 0;
+    benchmark_per_op("Copy out and scan, first 10 ranges ", 10, [&]() {
+        for (int i = 0; i < 10; i++) {
+            std::vector<std::string> all(rbt.begin(), rbt.end());
+            for (const auto& word : all)
+                copied += ranges[i].first <= word && word < ranges[i].second;
+        }
+    });
+
+    benchmark_per_op("Full in order traversal (op = key) ", rbt.size(), [&]() {
+        for (const auto& word : rbt)
+            copied += word.size();
+    });
+}
+
+// rbt_bench miss <ratio>: lookups of which the given fraction miss, against
+// the tree alone and behind a bloom filter.
+int miss_bench(double miss_ratio) {
+    auto words = read_words(word_count, "words");
+    auto rbt = RBTree<std::string>();
+    auto set = bloom_set<std::string>(word_count, set_fp_prob);
+    for (int i = 0; i < word_count; i++) {
+        rbt.insert(words[i]);
+        set.insert(words[i]);
+    }
+
+    // "#0", "#1", ... never occur in words
+    std::vector<std::string> queries;
+    std::mt19937 rng(42);
+    std::bernoulli_distribution miss(miss_ratio);
+    for (int i = 0; i < word_count; i++)
+        queries.push_back(miss(rng) ? "#" + std::to_string(i) : words[rng() % word_count]);
+
+    std::cout << "Red Black Tree"
+              << " @ " << word_count << " lookups, miss ratio " << miss_ratio << "\n";
+
+    int count = 0;
+    benchmark("Search ", [&]() {
+        for (int i = 0; i < word_count; i++)
+            count += rbt.contains(queries[i]);
+    });
+
+    benchmark("Search behind bloom filter ", [&]() {
+        for (int i = 0; i < word_count; i++)
+            count += set.contains(queries[i]);
+    });
+
+    std::cout << "Filter hit rate " << set.get_filter_hit_rate()
+              << ", descents saved " << set.get_descents_saved()
+              << ", false positives " << set.get_false_positive_count() << "\n";
+
+    return count;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 2 && std::string_view(argv[1]) == "miss")
+        return miss_bench(std::stod(argv[2]));
 
-int main() {
     auto rbt = RBTree<std::string>();
     auto words = read_words(word_count, "words");
 
@@ -17,6 +212,10 @@ int main() {
             rbt.insert(words[i]);
     });    
 
+    std::cout << "Node " << rbt.node_size << " bytes, "
+              << double(rbt.get_memory_usage()) / rbt.size()
+              << " bytes per node with arena slack\n";
+
     auto search_words = read_words(word_count, "shuffled_words");
 
     int count = 0;
@@ -25,5 +224,28 @@ int main() {
             count += rbt.contains(search_words[i]);
     });
 
+    std::cout << "Comparator policy @ " << compare_word_count << " words\n";
+    compare_bench<legacy_compare>("Search, != then < ", words, search_words);
+    compare_bench<counting_compare>("Search, three-way ", words, search_words);
+
+    index_bench(words, search_words);
+
+    bulk_bench(words);
+
+    std::vector<std::string> sorted_words(words);
+    std::sort(sorted_words.begin(), sorted_words.end());
+    range_bench(sorted_words);
+
+    size_t erased = 0;
+    benchmark_per_op("Erase ", word_count, [&]() {
+        for (int i = 0; i < word_count; i++)
+            erased += rbt.erase(search_words[i]);
+    });
+    std::cout << "Erased " << erased << ", " << rbt.size() << " left\n";
+
+    benchmark("Release ", [&]() {
+        rbt.clear();
+    });
+
     return count;
-}
\ No newline at end of file
+}
@@ -24,6 +24,10 @@ int main() {
         for(int i = 0; i< word_count; i++)
             count += st.contains(search_words[i]);
     });
+
+    benchmark("Release ", [&]() {
+        st.clear();
+    });
     
     return count;
 }
\ No newline at end of file
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Where a bit_array allocates its words. Huge pages cut the TLB misses of
+// random probes into arrays of many gigabytes.
+enum class bit_storage { heap, huge_pages };
+
+// Fixed size array of 64 bit words backing the bloom filters. The words
+// either live on the heap, in an anonymous mapping backed by 2 MB pages, or
+// are a private mapping of a file, in which case reading them touches the
+// page cache directly and writes copy the touched pages instead of reaching
+// the file.
+
+class bit_array {
+    static constexpr size_t huge_page_size = size_t(2) << 20;
+
+    struct release {
+        void* map_base;
+        size_t map_bytes;
+        bool from_file;
+
+        release() : map_base(nullptr), map_bytes(0), from_file(false) {}
+
+        release(void* base, size_t bytes, bool file)
+            : map_base(base), map_bytes(bytes), from_file(file) {}
+
+        void operator()(uint64_t* words) const {
+            if (map_base != nullptr)
+                munmap(map_base, map_bytes);
+            else
+                std::free(words);
+        }
+    };
+
+    using words_ptr = std::unique_ptr<uint64_t[], release>;
+
+    words_ptr m_words;
+    size_t m_size = 0;
+
+    bit_array(words_ptr words, size_t size)
+        : m_words(std::move(words)), m_size(size) {}
+
+  public:
+    bit_array() = default;
+
+    explicit bit_array(size_t size, bit_storage storage = bit_storage::heap)
+        : m_size(size) {
+        if (storage == bit_storage::huge_pages && size > 0)
+            m_words = map_huge_pages(size);
+        // calloc hands large arrays out as untouched zero pages, so memory is
+        // only committed as probes reach it
+        if (m_words == nullptr)
+            m_words = words_ptr(static_cast<uint64_t*>(std::calloc(size, sizeof(uint64_t))));
+    }
+
+    bit_array(const bit_array& other) : bit_array(other.m_size, other.storage()) {
+        std::copy(other.data(), other.data() + m_size, data());
+    }
+
+    bit_array(bit_array&&) = default;
+
+    bit_array& operator=(bit_array other) {
+        std::swap(m_words, other.m_words);
+        std::swap(m_size, other.m_size);
+        return *this;
+    }
+
+    // Maps size words stored offset bytes into the file at path. The file
+    // is only ever opened for reading.
+    static std::optional<bit_array> map_file(const std::string& path,
+                                             size_t offset, size_t size) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return std::nullopt;
+
+        struct stat st;
+        size_t bytes = offset + size * sizeof(uint64_t);
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < bytes || offset % 8) {
+            close(fd);
+            return std::nullopt;
+        }
+
+        void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED)
+            return std::nullopt;
+
+        auto words = reinterpret_cast<uint64_t*>(static_cast<char*>(base) + offset);
+        return bit_array(words_ptr(words, release{base, bytes, true}), size);
+    }
+
+    uint64_t& operator[](size_t i) { return m_words[i]; }
+
+    const uint64_t& operator[](size_t i) const { return m_words[i]; }
+
+    uint64_t* data() { return m_words.get(); }
+
+    const uint64_t* data() const { return m_words.get(); }
+
+    size_t size() const { return m_size; }
+
+    bool is_mapped() const { return m_words.get_deleter().from_file; }
+
+    bit_storage storage() const {
+        const auto& r = m_words.get_deleter();
+        return r.map_base != nullptr && !r.from_file ? bit_storage::huge_pages
+                                                     : bit_storage::heap;
+    }
+
+  private:
+    // Prefers explicitly reserved huge pages and falls back to asking for
+    // transparent huge pages. Returns null if no mapping could be made, the
+    // caller then allocates on the heap.
+    static words_ptr map_huge_pages(size_t size) {
+        size_t bytes = size * sizeof(uint64_t);
+        bytes = (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        void* base = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+#endif
+        if (base == MAP_FAILED) {
+            base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+            if (base == MAP_FAILED)
+                return nullptr;
+#ifdef MADV_HUGEPAGE
+            madvise(base, bytes, MADV_HUGEPAGE);
+#endif
+        }
+        return words_ptr(static_cast<uint64_t*>(base), release{base, bytes, false});
+    }
+};
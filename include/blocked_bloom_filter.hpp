@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "bloom_filter.hpp"
+
+// Every key is mapped to a single 64 byte block and all k bits are set
+// inside it, so add/test touch one cache line instead of k. The price is a
+// higher false positive rate, since blocks are unevenly loaded.
+// Putze, Sanders, Singler - Cache-, Hash- and Space-Efficient Bloom Filters
+
+template <typename value_type,
+          typename hash_func = Hasher<value_type>>
+struct blocked_bloom_filter {
+
+    static constexpr size_t block_bits = 512;
+
+    struct alignas(64) block {
+        uint64_t words[block_bits / 64] = {};
+    };
+
+    using container = std::vector<block>;
+
+    blocked_bloom_filter(size_t n, double p) : set_size(n) {
+        // same sizing as bloom_filter, rounded up to whole blocks
+        auto [m, k] = bloom_filter<value_type, hash_func>::optimal_shape(n, p);
+
+        block_count = (m + block_bits - 1) / block_bits;
+        bit_count = block_count * block_bits;
+        hash_func_count = k;
+        B.resize(block_count);
+    }
+
+    void add(const value_type& val) {
+        auto [a, b] = hash_values(val);
+        auto& blk = B[block_index(a)];
+        size_t step = a | 1;
+        for (size_t i = 0; i < hash_func_count; ++i) {
+            size_t bit = (b + i * step) % block_bits;
+            blk.words[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+    }
+
+    void add(const std::initializer_list<value_type>& vals) {
+        for (auto val : vals)
+            add(val);
+    }
+
+    bool test(const value_type& val) const {
+        auto [a, b] = hash_values(val);
+        const auto& blk = B[block_index(a)];
+        size_t step = a | 1;
+        for (size_t i = 0; i < hash_func_count; ++i) {
+            size_t bit = (b + i * step) % block_bits;
+            if ((blk.words[bit / 64] & (uint64_t(1) << (bit % 64))) == 0)
+                return false;
+        }
+        return true;
+    }
+
+    size_t get_bit_count() { return bit_count; }
+
+    size_t get_hash_func_count() { return hash_func_count; }
+
+    size_t get_block_count() { return block_count; }
+
+    // False positive rate of an unblocked filter with the same m and k
+    // after n insertions.
+    double get_classic_fp_rate() const {
+        double fill = 1 - std::exp(-double(hash_func_count) * set_size / bit_count);
+        return std::pow(fill, hash_func_count);
+    }
+
+    // Expected false positive rate of this filter after n insertions. The
+    // number of keys landing in a block is Poisson distributed with mean
+    // n / block_count, each block then behaves like a small bloom filter.
+    double get_fp_rate() const {
+        double lambda = double(set_size) / block_count;
+        double k = hash_func_count;
+        size_t limit = lambda + 16 * std::sqrt(lambda) + 16;
+        double rate = 0;
+        for (size_t i = 0; i <= limit; ++i) {
+            double log_poisson = i * std::log(lambda) - lambda - std::lgamma(i + 1.0);
+            double fill = 1 - std::pow(1 - 1.0 / block_bits, k * i);
+            rate += std::exp(log_poisson) * std::pow(fill, k);
+        }
+        return rate;
+    }
+
+    // Extra false positive rate paid for blocking.
+    double get_fp_rate_overhead() const {
+        return get_fp_rate() - get_classic_fp_rate();
+    }
+
+  private:
+    size_t set_size;
+    size_t bit_count;
+    size_t block_count;
+    size_t hash_func_count;
+    container B;
+
+    const hash_func hash_values = hash_func{};
+
+    size_t block_index(uint32_t a) const {
+        // multiply-shift maps the 32 bit hash onto [0, block_count)
+        return (uint64_t(a) * block_count) >> 32;
+    }
+};
@@ -4,57 +4,522 @@
 #include <bitset>
 #include <functional>
 #include <array>
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 #include <hash/fnv.h>
 #include <hash/xxhash.hpp>
 
+#include "bit_array.hpp"
+#include "golomb_coding.hpp"
+
+// Define BLOOM_FILTER_STATS to have bloom_filter count adds, tests and
+// positive tests. Without it the counters and their updates do not exist.
+#ifdef BLOOM_FILTER_STATS
+#include <atomic>
+
+// Counts with relaxed atomic increments, so threads testing one filter at
+// the same time do not lose counts. Copies take the current value.
+struct bloom_filter_counter {
+    std::atomic<size_t> value{0};
+
+    bloom_filter_counter() = default;
+    bloom_filter_counter(const bloom_filter_counter& other) noexcept : value(other.get()) {}
+
+    bloom_filter_counter& operator=(const bloom_filter_counter& other) noexcept {
+        value.store(other.get(), std::memory_order_relaxed);
+        return *this;
+    }
+
+    void add(size_t count) { value.fetch_add(count, std::memory_order_relaxed); }
+
+    size_t get() const noexcept { return value.load(std::memory_order_relaxed); }
+};
+
+#define BLOOM_FILTER_COUNT(counter) counter.add(1)
+#else
+#define BLOOM_FILTER_COUNT(counter) ((void)0)
+#endif
+
 template <typename value_type> 
 struct Hasher {
-    std::pair<uint32_t, uint32_t> operator()(value_type k) const {
+    // identifies the hash functions in saved filters
+    static constexpr uint32_t policy_id = 1;
+    // probes are reduced with % bit_count
+    static constexpr bool fast_range = false;
+    // width of each of the two hashes, which bounds the bits they can reach
+    static constexpr unsigned hash_bits = 32;
+
+    std::pair<uint32_t, uint32_t> operator()(const value_type& k) const {
         auto a = FNV::fnv1a(k);
         auto b = xxh::xxhash<32>(k);
         return {a, b};
     }
 };
 
+// Strings are hashed through a view of their bytes, so std::string,
+// std::string_view and C strings are all hashed in place, to the same values.
+template <>
+struct Hasher<std::string> {
+    static constexpr uint32_t policy_id = 1;
+    static constexpr bool fast_range = false;
+    static constexpr unsigned hash_bits = 32;
+
+    std::pair<uint32_t, uint32_t> operator()(std::string_view k) const {
+        const char* data = k.empty() ? "" : k.data();
+        auto a = FNV::fnv1a(static_cast<const void*>(data), k.size());
+        auto b = xxh::xxhash<32>(data, k.size());
+        return {a, b};
+    }
+};
+
+// Derives both hashes from a single 128 bit xxhash3 pass and lets the
+// filter map probes onto [0, bit_count) with a multiply and a shift
+// instead of a 64 bit division. Its 64 bit halves reach every bit of
+// filters past 2^32 bits, where Hasher's 32 bit ones do not.
+template <typename value_type>
+struct XXH3Hasher {
+    static constexpr uint32_t policy_id = 2;
+    static constexpr bool fast_range = true;
+    static constexpr unsigned hash_bits = 64;
+
+    std::pair<uint64_t, uint64_t> operator()(const value_type& k) const {
+        if constexpr (std::is_trivially_copyable_v<value_type>) {
+            auto h = xxh::xxhash3<128>(&k, sizeof(k));
+            return {h.low64, h.high64};
+        } else {
+            auto h = xxh::xxhash3<128>(k);
+            return {h.low64, h.high64};
+        }
+    }
+};
+
+template <>
+struct XXH3Hasher<std::string> {
+    static constexpr uint32_t policy_id = 2;
+    static constexpr bool fast_range = true;
+    static constexpr unsigned hash_bits = 64;
+
+    std::pair<uint64_t, uint64_t> operator()(std::string_view k) const {
+        auto h = xxh::xxhash3<128>(k.data(), k.size());
+        return {h.low64, h.high64};
+    }
+};
+
+// On disk layout written by bloom_filter::save, in native byte order. The
+// header is 64 bytes so the bit array that follows it is word aligned in
+// the file and in a mapping of it.
+struct bloom_filter_header {
+    static constexpr char bloom_magic[8] = {'B', 'L', 'O', 'O', 'M', 'F', 'L', 'T'};
+    static constexpr uint32_t current_version = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t hash_policy;
+    uint64_t bit_count;
+    uint64_t hash_func_count;
+    uint64_t word_count;
+    uint64_t reserved[3];
+};
+
+static_assert(sizeof(bloom_filter_header) == 64);
+
+// Wire format written by bloom_filter::save_compressed. The bits follow
+// either as raw words or, when that is smaller, as the Golomb-Rice coded
+// gaps between set bits, payload_words words either way.
+struct bloom_filter_compressed_header {
+    static constexpr char compressed_magic[8] = {'B', 'L', 'O', 'O', 'M', 'G', 'C', 'S'};
+    static constexpr uint32_t current_version = 2;
+
+    enum encoding : uint32_t { raw_words = 0, rice_gaps = 1 };
+
+    char magic[8];
+    uint32_t version;
+    uint32_t hash_policy;
+    uint64_t bit_count;
+    uint64_t hash_func_count;
+    uint64_t set_bit_count;
+    uint32_t encoding;
+    uint32_t rice_bits;
+    uint64_t payload_words;
+};
+
 template <typename value_type, 
           typename hash_func = Hasher<value_type>>
 struct bloom_filter {
 
-    using container = std::vector<bool>;
+    using container = bit_array;
+    using hash_type = decltype(std::declval<hash_func>()(std::declval<value_type>()));
+
+    // keys hashed and prefetched ahead of resolving their probes
+    static constexpr size_t batch_size = 32;
+
+    // Largest filter hash_func can address. Probes of 32 bit hashes never
+    // get past bit 2^32, the rest of a bigger filter would stay unused.
+    static constexpr size_t max_bit_count = hash_func::hash_bits < 64
+        ? size_t(1) << hash_func::hash_bits : std::numeric_limits<size_t>::max();
 
-    bloom_filter(size_t n, double p) {
+    // most hash functions a loaded filter may ask for, k = 64 already
+    // targets a false positive rate of 2^-64
+    static constexpr size_t max_hash_func_count = 64;
+
+    struct shape {
+        size_t bit_count;
+        size_t hash_func_count;
+    };
+
+    // The m and k giving a false positive rate of p at n keys, shared by
+    // every filter sized from n and p. Throws std::invalid_argument unless
+    // n > 0 and 0 < p < 1.
+    // https://hur.st/bloomfilter/
+    static shape optimal_shape(size_t n, double p) {
         using namespace std;
 
-        // https://hur.st/bloomfilter/
-        int m = ceil(n * log(p) / log(1 / pow(2, log(2))));
-        int k = ceil((m / n) * log(2));
+        if (n == 0 || !(p > 0 && p < 1))
+            throw invalid_argument("bloom_filter: n must be positive and p in (0, 1)");
+        double m = ceil(n * log(p) / log(1 / pow(2, log(2))));
+        if (m >= double(numeric_limits<size_t>::max()))
+            throw invalid_argument("bloom_filter: too many bits");
+        size_t k = max(1.0, round(m / n * log(2)));
+        return {size_t(m), k};
+    }
 
+    // Bit probed by hash function i of a key hashed to (a, b) in a filter
+    // of m bits, by double hashing. Shared by every filter probing a flat
+    // bit or counter array.
+    static size_t probe(size_t i, size_t a, size_t b, size_t m) {
+        if constexpr (hash_func::fast_range) {
+            // https://lemire.me/blog/2016/06/27/a-fast-alternative-to-the-modulo-reduction/
+            __extension__ using uint128 = unsigned __int128;
+            return (uint128(a + i * b) * m) >> 64;
+        } else {
+            return (a + i * b) % m;
+        }
+    }
+
+    // A filter for n keys at a false positive rate of p. Throws
+    // std::invalid_argument for n, p or a resulting shape with_shape
+    // rejects.
+    bloom_filter(size_t n, double p, bit_storage storage = bit_storage::heap) {
+        auto [m, k] = optimal_shape(n, p);
+        check_shape(m, k);
         bit_count = m;
         hash_func_count = k;
-        B.resize(m);
+        B = container((m + 63) / 64, storage);
     }
 
-    void add(const value_type& val) {
-        auto [a, b] = hash_values(val);
-        for (size_t i = 0; i < hash_func_count; ++i)
-            B[nthHash(i, a, b)] = true;
+    // A filter of exactly m bits probed by k hash functions. Throws
+    // std::invalid_argument unless valid_shape(m, k).
+    static bloom_filter with_shape(size_t m, size_t k,
+                                   bit_storage storage = bit_storage::heap) {
+        check_shape(m, k);
+        return bloom_filter(m, k, container((m + 63) / 64, storage));
+    }
+
+    // Any key hash_func accepts can be added or tested without building a
+    // value_type first, e.g. a std::string_view into a bloom_filter of
+    // std::string.
+    template <typename key_type = value_type>
+    void add(const key_type& val) {
+        add_hashed(hash(val));
     }
 
     void add(const std::initializer_list<value_type>& vals) {
-        for (auto val : vals)
+        for (const auto& val : vals)
             add(val);
     }
 
-    bool test(const value_type& val) const {
-        auto [a, b] = hash_values(val);
+    void add(const char* data, size_t len) {
+        add(std::string_view(data, len));
+    }
+
+    template <typename key_type = value_type>
+    bool test(const key_type& val) const {
+        return test_hashed(hash(val));
+    }
+
+    bool test(const char* data, size_t len) const {
+        return test(std::string_view(data, len));
+    }
+
+    // Lets filters built from several bloom_filters with the same hash_func
+    // hash a key once and probe every one of them.
+    template <typename key_type = value_type>
+    hash_type hash(const key_type& val) const { return hash_values(val); }
+
+    void add_hashed(hash_type h) {
+        BLOOM_FILTER_COUNT(add_count);
+        auto [a, b] = h;
+        for (size_t i = 0; i < hash_func_count; ++i)
+            set_bit(probe(i, a, b, bit_count));
+    }
+
+    bool test_hashed(hash_type h) const {
+        BLOOM_FILTER_COUNT(test_count);
+        auto [a, b] = h;
         for (size_t i = 0; i < hash_func_count; ++i)
-            if (B[nthHash(i, a, b)] == false)
+            if (get_bit(probe(i, a, b, bit_count)) == false)
                 return false;
+        BLOOM_FILTER_COUNT(positive_count);
+        return true;
+    }
+
+    // Hashes a batch of keys, prefetches every word they probe and only
+    // then touches the bit array, so the cache misses of a whole batch
+    // overlap instead of stalling one key at a time.
+    template <typename Iter>
+    void add_many(Iter first, Iter last) {
+        hash_type hashes[batch_size];
+        while (first != last) {
+            size_t count = hash_batch(first, last, hashes);
+            for (size_t j = 0; j < count; ++j)
+                add_hashed(hashes[j]);
+        }
+    }
+
+    // Same pipelining as add_many, bit j of the result is test(*(first + j)).
+    template <typename Iter>
+    std::vector<bool> test_many(Iter first, Iter last) const {
+        std::vector<bool> result;
+        hash_type hashes[batch_size];
+        while (first != last) {
+            size_t count = hash_batch(first, last, hashes);
+            for (size_t j = 0; j < count; ++j)
+                result.push_back(test_hashed(hashes[j]));
+        }
+        return result;
+    }
+
+    // Resets every bit, a word at a time.
+    void clear() { std::fill(B.data(), B.data() + B.size(), 0); }
+
+    // Both merges require filters of the same shape, built with the same m,
+    // k and hash_func. The union holds every key of either filter exactly as
+    // if they had all been added to one, the intersection is a filter for
+    // the keys common to both, with a false positive rate at most that of
+    // the union.
+    bool merge_union(const bloom_filter& other) {
+        if (!same_shape(other))
+            return false;
+        merge_words(other, word_or{});
+        merge_stats(other);
+        return true;
+    }
+
+    bool merge_intersection(const bloom_filter& other) {
+        if (!same_shape(other))
+            return false;
+        merge_words(other, word_and{});
+        merge_stats(other);
         return true;
     }
 
+    // Writes the filter in the bloom_filter_header format.
+    bool save(const std::string& path) const {
+        bloom_filter_header header = {};
+        std::memcpy(header.magic, header.bloom_magic, sizeof(header.magic));
+        header.version = header.current_version;
+        header.hash_policy = hash_func::policy_id;
+        header.bit_count = bit_count;
+        header.hash_func_count = hash_func_count;
+        header.word_count = B.size();
+
+        std::ofstream fs(path, std::ios::binary);
+        fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        fs.write(reinterpret_cast<const char*>(B.data()), B.size() * sizeof(uint64_t));
+        return fs.good();
+    }
+
+    // Maps a saved filter instead of reading it, test runs straight off the
+    // mapped pages. Fails if the file is not a filter saved with the same
+    // hash_func.
+    static std::optional<bloom_filter> open_mapped(const std::string& path) {
+        bloom_filter_header header;
+        std::ifstream fs(path, std::ios::binary);
+        if (!fs.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            return std::nullopt;
+
+        if (std::memcmp(header.magic, header.bloom_magic, sizeof(header.magic)) != 0
+            || header.version != header.current_version
+            || header.hash_policy != hash_func::policy_id
+            || header.word_count != (header.bit_count + 63) / 64
+            || !valid_shape(header.bit_count, header.hash_func_count))
+            return std::nullopt;
+
+        auto words = container::map_file(path, sizeof(header), header.word_count);
+        if (!words)
+            return std::nullopt;
+        return bloom_filter(header.bit_count, header.hash_func_count, std::move(*words));
+    }
+
+    bool is_mapped() const { return B.is_mapped(); }
+
+    // Writes the filter for shipping. Set bits are sent as Golomb-Rice
+    // coded gaps, which pays off below roughly a third of the bits set. A
+    // fuller filter is close to random and is sent as raw words. Either way
+    // the output is streamed, only a chunk of it is buffered.
+    bool save_compressed(std::ostream& os) const {
+        using header_type = bloom_filter_compressed_header;
+
+        header_type header = {};
+        std::memcpy(header.magic, header.compressed_magic, sizeof(header.magic));
+        header.version = header.current_version;
+        header.hash_policy = hash_func::policy_id;
+        header.bit_count = bit_count;
+        header.hash_func_count = hash_func_count;
+        header.set_bit_count = count_set_bits();
+
+        // rice parameter for geometric gaps of mean m / set bits
+        double mean_gap = header.set_bit_count ? double(bit_count) / header.set_bit_count : 1;
+        header.rice_bits = std::max(0.0, std::floor(std::log2(mean_gap * std::log(2))));
+        uint64_t rice_size = 0;
+        for_each_gap([&](uint64_t gap) { rice_size += rice_code_bits(gap, header.rice_bits); });
+        uint64_t rice_words = (rice_size + 63) / 64;
+        if (rice_words < B.size()) {
+            header.encoding = header_type::rice_gaps;
+            header.payload_words = rice_words;
+        } else {
+            header.encoding = header_type::raw_words;
+            header.payload_words = B.size();
+        }
+
+        os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (header.encoding == header_type::raw_words) {
+            os.write(reinterpret_cast<const char*>(B.data()), B.size() * sizeof(uint64_t));
+            return os.good();
+        }
+
+        rice_writer out(os, header.rice_bits);
+        for_each_gap([&](uint64_t gap) { out.write(gap); });
+        out.finish();
+        return os.good() && out.bytes_written() == rice_words * sizeof(uint64_t);
+    }
+
+    // Reads a filter written by save_compressed, setting bits straight into
+    // the new filter as they are decoded. Reads exactly the filter's words,
+    // so several filters can be sent down one stream. Filters of more than
+    // max_bits bits are refused before anything is allocated for them.
+    static std::optional<bloom_filter> load_compressed(std::istream& is,
+                                                       size_t max_bits = size_t(1) << 32) {
+        using header_type = bloom_filter_compressed_header;
+
+        header_type header;
+        if (!is.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            return std::nullopt;
+        if (std::memcmp(header.magic, header.compressed_magic, sizeof(header.magic)) != 0
+            || header.version != header.current_version
+            || header.hash_policy != hash_func::policy_id
+            || !valid_shape(header.bit_count, header.hash_func_count)
+            || header.bit_count > max_bits
+            || header.set_bit_count > header.bit_count
+            || header.rice_bits >= 64)
+            return std::nullopt;
+
+        uint64_t word_count = (header.bit_count + 63) / 64;
+        if (header.encoding == header_type::raw_words) {
+            if (header.payload_words != word_count)
+                return std::nullopt;
+            auto bf = with_shape(header.bit_count, header.hash_func_count);
+            if (!is.read(reinterpret_cast<char*>(bf.B.data()), bf.B.size() * sizeof(uint64_t)))
+                return std::nullopt;
+            // bits past bit_count in the last word are no part of the filter
+            bf.B[word_count - 1] &= low_bits_mask(header.bit_count - (word_count - 1) * 64);
+            if (bf.count_set_bits() != header.set_bit_count)
+                return std::nullopt;
+            return bf;
+        }
+        // every code takes at least rice_bits + 1 bits
+        if (header.encoding != header_type::rice_gaps
+            || header.payload_words >= word_count
+            || header.payload_words * 64 / (header.rice_bits + 1) < header.set_bit_count)
+            return std::nullopt;
+
+        auto bf = with_shape(header.bit_count, header.hash_func_count);
+        rice_reader in(is, header.rice_bits, header.payload_words);
+        uint64_t next = 0;
+        for (uint64_t j = 0; j < header.set_bit_count; ++j) {
+            uint64_t pos = next + in.read();
+            if (!in.good() || pos >= bf.bit_count)
+                return std::nullopt;
+            bf.set_bit(pos);
+            next = pos + 1;
+        }
+        if (!in.done())
+            return std::nullopt;
+        return bf;
+    }
+
+    // Number of set bits, counted a word at a time.
+    size_t count_set_bits() const {
+        const uint64_t* words = B.data();
+        size_t count = 0;
+        size_t i = 0;
+#ifdef __AVX2__
+        // Mula, Kurz, Lemire - Faster Population Counts Using AVX2 Instructions
+        const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low_mask = _mm256_set1_epi8(0x0f);
+        __m256i acc = _mm256_setzero_si256();
+        for (; i + 4 <= B.size(); i += 4) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+            __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low_mask));
+            __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask));
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi),
+                                                        _mm256_setzero_si256()));
+        }
+        count += _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1)
+               + _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3);
+#endif
+        for (; i < B.size(); ++i)
+            count += __builtin_popcountll(words[i]);
+        return count;
+    }
+
+    // Fraction of bits set, 1 - 1/e at the n the filter was sized for.
+    double get_fill_ratio() const {
+        return double(count_set_bits()) / bit_count;
+    }
+
+    // Number of distinct keys added, estimated from the fill ratio.
+    // Swamidass, Baldi - Mathematical correction for fingerprint similarity measures
+    double estimate_cardinality() const {
+        double fill = get_fill_ratio();
+        if (fill >= 1)
+            return std::numeric_limits<double>::infinity();
+        return -double(bit_count) / hash_func_count * std::log1p(-fill);
+    }
+
+    // False positive rate at the current fill, a key absent from the filter
+    // passes if all of its k probes land on set bits.
+    double estimate_fp_rate() const {
+        return std::pow(get_fill_ratio(), hash_func_count);
+    }
+
+#ifdef BLOOM_FILTER_STATS
+    size_t get_add_count() const { return add_count.get(); }
+
+    size_t get_test_count() const { return test_count.get(); }
+
+    size_t get_positive_count() const { return positive_count.get(); }
+#endif
+
     size_t get_bit_count() { return bit_count; }
 
     size_t get_hash_func_count() { return hash_func_count; }
@@ -64,9 +529,101 @@ struct bloom_filter {
     size_t hash_func_count;
     container B;
 
+#ifdef BLOOM_FILTER_STATS
+    bloom_filter_counter add_count;
+    mutable bloom_filter_counter test_count;
+    mutable bloom_filter_counter positive_count;
+#endif
+
     const hash_func hash_values = hash_func{};
 
-    size_t nthHash(int n, size_t a, size_t b) const {
-        return (a + n * b) % bit_count;
+    bloom_filter(size_t m, size_t k, container words)
+        : bit_count(m), hash_func_count(k), B(std::move(words)) {}
+
+    // Shapes a filter may have, built or read from a file or stream.
+    static bool valid_shape(uint64_t m, uint64_t k) {
+        return m > 0 && m <= max_bit_count && k > 0 && k <= max_hash_func_count;
+    }
+
+    static void check_shape(size_t m, size_t k) {
+        if (!valid_shape(m, k))
+            throw std::invalid_argument("bloom_filter: m and k must be positive, m at most "
+                                        "max_bit_count and k at most max_hash_func_count");
+    }
+
+    bool same_shape(const bloom_filter& other) const {
+        return bit_count == other.bit_count
+            && hash_func_count == other.hash_func_count;
+    }
+
+    // A merged filter keeps the counts of both.
+    void merge_stats([[maybe_unused]] const bloom_filter& other) {
+#ifdef BLOOM_FILTER_STATS
+        add_count.add(other.add_count.get());
+        test_count.add(other.test_count.get());
+        positive_count.add(other.positive_count.get());
+#endif
+    }
+
+    struct word_or {
+        uint64_t operator()(uint64_t x, uint64_t y) const { return x | y; }
+#ifdef __AVX2__
+        __m256i operator()(__m256i x, __m256i y) const { return _mm256_or_si256(x, y); }
+#endif
+    };
+
+    struct word_and {
+        uint64_t operator()(uint64_t x, uint64_t y) const { return x & y; }
+#ifdef __AVX2__
+        __m256i operator()(__m256i x, __m256i y) const { return _mm256_and_si256(x, y); }
+#endif
+    };
+
+    template <typename Op>
+    void merge_words(const bloom_filter& other, Op op) {
+        uint64_t* dst = B.data();
+        const uint64_t* src = other.B.data();
+        size_t i = 0;
+#ifdef __AVX2__
+        for (; i + 4 <= B.size(); i += 4) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), op(x, y));
+        }
+#endif
+        // tail words, or all of them without AVX2
+        for (; i < B.size(); ++i)
+            dst[i] = op(dst[i], src[i]);
+    }
+
+    void set_bit(size_t i) { B[i / 64] |= uint64_t(1) << (i % 64); }
+
+    // Calls f with the number of clear bits before each set bit.
+    template <typename F>
+    void for_each_gap(F f) const {
+        uint64_t next = 0;
+        for (size_t i = 0; i < B.size(); ++i)
+            for (uint64_t w = B[i]; w != 0; w &= w - 1) {
+                uint64_t pos = i * 64 + __builtin_ctzll(w);
+                f(pos - next);
+                next = pos + 1;
+            }
+    }
+
+    bool get_bit(size_t i) const { return B[i / 64] & (uint64_t(1) << (i % 64)); }
+
+    // Hashes up to batch_size keys starting at first, advancing it, and
+    // prefetches the word behind every probe. Returns the number of keys.
+    template <typename Iter>
+    size_t hash_batch(Iter& first, Iter last, hash_type* hashes) const {
+        size_t count = 0;
+        for (; first != last && count < batch_size; ++first)
+            hashes[count++] = hash_values(*first);
+        for (size_t j = 0; j < count; ++j) {
+            auto [a, b] = hashes[j];
+            for (size_t i = 0; i < hash_func_count; ++i)
+                __builtin_prefetch(&B[probe(i, a, b, bit_count) / 64]);
+        }
+        return count;
     }
 };
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "bloom_filter.hpp"
+#include "rbt.hpp"
+
+// Ordered set that keeps a bloom_filter in front of an RBTree. Keys are
+// inserted into both, and lookups the filter rejects return without
+// descending the tree, which makes misses cost k bit probes instead of a
+// root to leaf walk with two comparisons per level.
+
+template <typename value_type,
+          typename hash_func = Hasher<value_type>>
+class bloom_set {
+    bloom_filter<value_type, hash_func> m_filter;
+    RBTree<value_type> m_tree;
+
+    mutable size_t m_lookups = 0;
+    mutable size_t m_rejected = 0;
+    mutable size_t m_false_positives = 0;
+
+  public:
+    // n is the expected number of keys and p the false positive rate of the
+    // filter, the fraction of misses that still descend the tree.
+    bloom_set(size_t n, double p) : m_filter(n, p) {}
+
+    void insert(const value_type& val) {
+        m_filter.add(val);
+        m_tree.insert(val);
+    }
+
+    bool contains(const value_type& val) const {
+        ++m_lookups;
+        if (!m_filter.test(val)) {
+            ++m_rejected;
+            return false;
+        }
+        bool found = m_tree.contains(val);
+        m_false_positives += !found;
+        return found;
+    }
+
+    size_t size() { return m_tree.size(); }
+
+    bool empty() { return m_tree.empty(); }
+
+    size_t get_lookup_count() const { return m_lookups; }
+
+    // Lookups answered by the filter alone, each one a tree descent saved.
+    size_t get_descents_saved() const { return m_rejected; }
+
+    // Lookups the filter let through for keys not in the set.
+    size_t get_false_positive_count() const { return m_false_positives; }
+
+    // Fraction of lookups the filter answered on its own.
+    double get_filter_hit_rate() const {
+        return m_lookups == 0 ? 0 : double(m_rejected) / m_lookups;
+    }
+
+    void reset_stats() {
+        m_lookups = m_rejected = m_false_positives = 0;
+    }
+};
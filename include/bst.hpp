@@ -3,13 +3,16 @@
 #include <memory>
 #include <iostream>
 #include <optional>
+#include <utility>
+#include "common.hpp"
+#include "node_arena.hpp"
 
-template<typename value_type>
+template<typename value_type, typename Compare = three_way_compare<value_type>>
 class BSTree {
     struct Node;
 
     using raw_ptr    = Node*;
-    using unique_ptr = std::unique_ptr<Node>;
+    using unique_ptr = typename node_arena<Node>::unique_ptr;
 
     struct Node {
         value_type val;
@@ -19,14 +22,20 @@ class BSTree {
         explicit Node(const value_type& v) : val(v) {}
     };
 
+    node_arena<Node> m_nodes;
     unique_ptr m_root = nullptr;
     size_t m_size = 0;
 
+    Compare compare;
+
     raw_ptr find(const value_type& val) const {
         raw_ptr node = m_root.get();
-        while (node != nullptr && val != node->val)
-            if (val < node->val) node = node->left.get();
-            else                 node = node->right.get();
+        while (node != nullptr) {
+            int c = compare(val, node->val);
+            if (c == 0)
+                break;
+            node = c < 0 ? node->left.get() : node->right.get();
+        }
         return node;
     }
 
@@ -53,6 +62,13 @@ class BSTree {
         return node;
     }
 
+    // Replaces node with child in its parent and frees node.
+    void unlink(raw_ptr node, unique_ptr child) {
+        if (child != nullptr)
+            child->parent = node->parent;
+        m_nodes.recycle(std::exchange(owner(node), std::move(child)));
+    }
+
     template<typename Func>
     void transform(unique_ptr& node, Func f) {
         if (node == nullptr) return;
@@ -64,6 +80,28 @@ class BSTree {
   public:
     BSTree() = default;
 
+    explicit BSTree(Compare c) : compare(std::move(c)) {}
+
+    ~BSTree() {
+        m_nodes.release_tree(std::move(m_root));
+    }
+
+    // Leaves other empty, with a copy of the comparator rather than a
+    // moved from one.
+    BSTree(BSTree&& other) noexcept
+        : m_nodes(std::move(other.m_nodes)),
+          m_root(std::move(other.m_root)),
+          m_size(std::exchange(other.m_size, 0)),
+          compare(other.compare) {}
+
+    BSTree& operator=(BSTree&& other) noexcept {
+        m_nodes.swap(other.m_nodes);
+        std::swap(m_root, other.m_root);
+        std::swap(m_size, other.m_size);
+        std::swap(compare, other.compare);
+        return *this;
+    }
+
     BSTree(std::initializer_list<value_type> vals) {
         for (auto& val : vals)
             insert(val);
@@ -71,23 +109,28 @@ class BSTree {
 
     size_t size() const { return m_size; }
     bool empty() const { return m_size == 0; }
-    void clear() { m_root.release(); }
+    void clear() {
+        m_nodes.release_tree(std::move(m_root));
+        m_nodes.clear();
+        m_size = 0;
+    }
 
     void insert(const value_type& val) {
         raw_ptr parent = nullptr;
         raw_ptr node = m_root.get();
+        bool left = false;
         while (node != nullptr) {
             parent = node;
-            if (val < node->val) node = node->left.get();
-            else                 node = node->right.get();
+            left = compare(val, node->val) < 0;
+            node = left ? node->left.get() : node->right.get();
         }
         if (parent == nullptr)
-            m_root = std::make_unique<Node>(val);
-        else if (val < parent->val) {
-            parent->left = std::make_unique<Node>(val);
+            m_root = m_nodes.make(val);
+        else if (left) {
+            parent->left = m_nodes.make(val);
             parent->left->parent = parent;
         } else {
-            parent->right = std::make_unique<Node>(val);
+            parent->right = m_nodes.make(val);
             parent->right->parent = parent;
         }
         ++m_size;
@@ -98,26 +141,20 @@ class BSTree {
         if (node == nullptr)
             return;
         if (node->left == nullptr) {
-            auto& o = owner(node);
-            o = std::move(node->right);
+            unlink(node, std::move(node->right));
         } else if (node->right == nullptr) {
-            auto& o = owner(node);
-            o = std::move(node->left);
+            unlink(node, std::move(node->left));
         } else {
             raw_ptr succ = find_minimum(node->right);
             node->val = succ->val;
             // succ guaranteed not to be null and to have only a right child
-            owner(succ).reset(succ->right.release());
+            unlink(succ, std::move(succ->right));
         }
         --m_size;
     }
 
     bool contains(const value_type& val) const {
-        raw_ptr node = m_root.get();
-        while (node != nullptr && val != node->val)
-            if (val < node->val) node = node->left.get();
-            else                 node = node->right.get();
-        return node != nullptr;
+        return find(val) != nullptr;
     }
 
     value_type minimum() const {
@@ -4,10 +4,63 @@
 #include <iostream>
 #include <memory>
 #include <optional>
+#include <cstdint>
+#include <string>
+
+// Negative, zero or positive as a is less than, equal to or greater than b.
+// The trees descend with one call per node where a != and a < would be two,
+// and for strings that is one pass over the characters instead of two.
+template <typename T>
+struct three_way_compare {
+    int operator()(const T& a, const T& b) const { return (b < a) - (a < b); }
+};
+
+template <typename CharT, typename Traits, typename Alloc>
+struct three_way_compare<std::basic_string<CharT, Traits, Alloc>> {
+    int operator()(const std::basic_string<CharT, Traits, Alloc>& a,
+                   const std::basic_string<CharT, Traits, Alloc>& b) const {
+        return a.compare(b);
+    }
+};
+
+// Pointer with a one bit tag in its low bit, free in any pointer to a type
+// aligned to two bytes or more. Converts to and assigns from a plain
+// pointer, which leaves the tag alone, so it can stand in for a node's
+// parent pointer.
+template <typename N>
+class tagged_ptr {
+    uintptr_t bits = 0;
+
+  public:
+    tagged_ptr() = default;
+    tagged_ptr(const tagged_ptr& other) = delete;
+
+    tagged_ptr& operator=(const tagged_ptr& other) {
+        return *this = static_cast<N*>(other);
+    }
+
+    tagged_ptr& operator=(N* ptr) {
+        bits = reinterpret_cast<uintptr_t>(ptr) | (bits & 1);
+        return *this;
+    }
+
+    operator N*() const { return reinterpret_cast<N*>(bits & ~uintptr_t(1)); }
+
+    N* operator->() const { return *this; }
+
+    bool tag() const { return bits & 1; }
+
+    void set_tag(bool t) {
+        static_assert(alignof(N) >= 2, "the low bit must be free");
+        bits = (bits & ~uintptr_t(1)) | uintptr_t(t);
+    }
+};
 
 template <typename N> 
 N* parent(N* node) {
-    return node ? node->parent : nullptr;
+    if (node == nullptr)
+        return nullptr;
+    return node->parent;
 }
 
 template <typename N>
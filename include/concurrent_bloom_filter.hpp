@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "bloom_filter.hpp"
+
+// A bloom filter that can be filled and queried from many threads at once.
+// Bits are only ever set, so add is a relaxed fetch_or per probe and test
+// is a handful of relaxed loads: both are wait-free. A test racing with the
+// add of the same key may miss it, once add returns the key is visible to
+// every test that happens after it.
+
+template <typename value_type,
+          typename hash_func = Hasher<value_type>>
+struct concurrent_bloom_filter {
+
+    using word = std::atomic<uint64_t>;
+    using filter = bloom_filter<value_type, hash_func>;
+    using container = std::vector<word>;
+
+    concurrent_bloom_filter(size_t n, double p) {
+        auto [m, k] = filter::optimal_shape(n, p);
+        bit_count = m;
+        hash_func_count = k;
+        B = container((m + 63) / 64);
+    }
+
+    void add(const value_type& val) {
+        auto [a, b] = hash_values(val);
+        for (size_t i = 0; i < hash_func_count; ++i) {
+            size_t bit = filter::probe(i, a, b, bit_count);
+            B[bit / 64].fetch_or(uint64_t(1) << (bit % 64),
+                                 std::memory_order_relaxed);
+        }
+    }
+
+    void add(const std::initializer_list<value_type>& vals) {
+        for (auto val : vals)
+            add(val);
+    }
+
+    bool test(const value_type& val) const {
+        auto [a, b] = hash_values(val);
+        for (size_t i = 0; i < hash_func_count; ++i) {
+            size_t bit = filter::probe(i, a, b, bit_count);
+            uint64_t w = B[bit / 64].load(std::memory_order_relaxed);
+            if ((w & (uint64_t(1) << (bit % 64))) == 0)
+                return false;
+        }
+        return true;
+    }
+
+    size_t get_bit_count() { return bit_count; }
+
+    size_t get_hash_func_count() { return hash_func_count; }
+
+  private:
+    size_t bit_count;
+    size_t hash_func_count;
+    container B;
+
+    const hash_func hash_values = hash_func{};
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "bloom_filter.hpp"
+
+// A bloom filter with a 4 bit counter in place of every bit, sixteen
+// counters packed per word. add increments and remove decrements the k
+// counters of a key, so keys can be deleted. Counters saturate at 15 and
+// from then on are never decremented, which keeps removals from ever
+// introducing false negatives.
+
+template <typename value_type,
+          typename hash_func = Hasher<value_type>>
+struct counting_bloom_filter {
+
+    using filter = bloom_filter<value_type, hash_func>;
+    using container = std::vector<uint64_t>;
+
+    static constexpr size_t counter_bits = 4;
+    static constexpr size_t counters_per_word = 64 / counter_bits;
+    static constexpr uint64_t counter_max = (1 << counter_bits) - 1;
+
+    counting_bloom_filter(size_t n, double p) {
+        auto [m, k] = filter::optimal_shape(n, p);
+        bit_count = m;
+        hash_func_count = k;
+        C.resize((m + counters_per_word - 1) / counters_per_word);
+    }
+
+    void add(const value_type& val) {
+        auto [a, b] = hash_values(val);
+        for (size_t i = 0; i < hash_func_count; ++i) {
+            size_t j = filter::probe(i, a, b, bit_count);
+            if (get_counter(j) < counter_max)
+                C[j / counters_per_word] += uint64_t(1) << shift(j);
+        }
+    }
+
+    void add(const std::initializer_list<value_type>& vals) {
+        for (auto val : vals)
+            add(val);
+    }
+
+    // Removing a key that was never added would decrement counters owned
+    // by other keys, so keys the filter rejects are ignored.
+    void remove(const value_type& val) {
+        if (!test(val))
+            return;
+        auto [a, b] = hash_values(val);
+        for (size_t i = 0; i < hash_func_count; ++i) {
+            size_t j = filter::probe(i, a, b, bit_count);
+            if (get_counter(j) < counter_max)
+                C[j / counters_per_word] -= uint64_t(1) << shift(j);
+        }
+    }
+
+    bool test(const value_type& val) const {
+        auto [a, b] = hash_values(val);
+        for (size_t i = 0; i < hash_func_count; ++i)
+            if (get_counter(filter::probe(i, a, b, bit_count)) == 0)
+                return false;
+        return true;
+    }
+
+    // Number of counters, the m of an equivalent bloom_filter.
+    size_t get_bit_count() { return bit_count; }
+
+    size_t get_hash_func_count() { return hash_func_count; }
+
+    // Bytes taken by the counters, counter_bits times a bloom_filter.
+    size_t get_memory_usage() { return C.size() * sizeof(uint64_t); }
+
+  private:
+    size_t bit_count;
+    size_t hash_func_count;
+    container C;
+
+    const hash_func hash_values = hash_func{};
+
+
+    static size_t shift(size_t j) { return (j % counters_per_word) * counter_bits; }
+
+    uint64_t get_counter(size_t j) const {
+        return (C[j / counters_per_word] >> shift(j)) & counter_max;
+    }
+};
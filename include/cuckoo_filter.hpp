@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "bloom_filter.hpp"
+
+// Cuckoo filter with buckets of four fingerprints packed into 64 bit words,
+// one word per bucket with 16 bit fingerprints and two with 32 bit ones.
+// Every key has two candidate buckets, the second derived from the first
+// and the fingerprint alone, so fingerprints can be moved between them
+// without the key. At 95% load the false positive rate is about
+// 8 / 2^fingerprint_bits: ~1.2e-4 for 16 bits and ~1.9e-9 for 32, at
+// ~17 and ~34 bits per key. Unlike bloom_filter, keys can be removed.
+// Fan, Andersen, Kaminsky, Mitzenmacher - Cuckoo Filter: Practically Better Than Bloom
+
+template <typename value_type,
+          size_t fingerprint_bits = 16,
+          typename hash_func = Hasher<value_type>>
+struct cuckoo_filter {
+
+    static_assert(fingerprint_bits == 16 || fingerprint_bits == 32,
+                  "fingerprints are 16 or 32 bits");
+
+    using container = std::vector<uint64_t>;
+
+    static constexpr size_t bucket_size = 4;
+    static constexpr size_t words_per_bucket = bucket_size * fingerprint_bits / 64;
+    static constexpr size_t slots_per_word = 64 / fingerprint_bits;
+    static constexpr size_t max_kicks = 500;
+    static constexpr double max_load = 0.95;
+
+    explicit cuckoo_filter(size_t n) {
+        // bucket count is a power of two so the alternate bucket can be
+        // found with a xor
+        size_t needed = std::ceil(n / (bucket_size * max_load));
+        bucket_count = 1;
+        while (bucket_count < needed)
+            bucket_count *= 2;
+        B.resize(bucket_count * words_per_bucket);
+    }
+
+    // Fails once the table is too full to place the key. The key that could
+    // not be placed is kept aside, so no key already added is ever lost.
+    bool add(const value_type& val) {
+        if (victim.used)
+            return false;
+        auto [i, fp] = index_and_fingerprint(val);
+        if (insert(i, fp) || insert(alt_index(i, fp), fp)) {
+            ++m_size;
+            return true;
+        }
+
+        // kick fingerprints out to their alternate buckets until one fits
+        for (size_t kick = 0; kick < max_kicks; ++kick) {
+            size_t slot = rng() % bucket_size;
+            uint64_t out = get_slot(i, slot);
+            set_slot(i, slot, fp);
+            fp = out;
+            i = alt_index(i, fp);
+            if (insert(i, fp)) {
+                ++m_size;
+                return true;
+            }
+        }
+
+        victim = {true, i, fp};
+        ++m_size;
+        return true;
+    }
+
+    void add(const std::initializer_list<value_type>& vals) {
+        for (const auto& val : vals)
+            add(val);
+    }
+
+    bool test(const value_type& val) const {
+        auto [i1, fp] = index_and_fingerprint(val);
+        size_t i2 = alt_index(i1, fp);
+        if (victim.used && victim.fp == fp && (victim.index == i1 || victim.index == i2))
+            return true;
+        return contains(i1, fp) || contains(i2, fp);
+    }
+
+    // Only keys that were added may be removed, removing any other key can
+    // delete the fingerprint of a key that collides with it.
+    bool remove(const value_type& val) {
+        auto [i1, fp] = index_and_fingerprint(val);
+        size_t i2 = alt_index(i1, fp);
+        if (erase(i1, fp) || erase(i2, fp)) {
+            --m_size;
+            if (victim.used) {
+                // the freed slot may let the victim back into the table
+                auto v = victim;
+                victim.used = false;
+                if (!insert(v.index, v.fp) && !insert(alt_index(v.index, v.fp), v.fp))
+                    victim = v;
+            }
+            return true;
+        }
+        if (victim.used && victim.fp == fp && (victim.index == i1 || victim.index == i2)) {
+            victim.used = false;
+            --m_size;
+            return true;
+        }
+        return false;
+    }
+
+    size_t size() const { return m_size; }
+
+    size_t get_bucket_count() const { return bucket_count; }
+
+    size_t get_memory_usage() const { return B.size() * sizeof(uint64_t); }
+
+    double get_bits_per_key() const {
+        return m_size == 0 ? 0 : 8.0 * get_memory_usage() / m_size;
+    }
+
+  private:
+    struct victim_slot {
+        bool used = false;
+        size_t index = 0;
+        uint64_t fp = 0;
+    };
+
+    static constexpr uint64_t fp_mask = (uint64_t(1) << fingerprint_bits) - 1;
+
+    size_t bucket_count;
+    size_t m_size = 0;
+    victim_slot victim;
+    std::minstd_rand rng;
+    container B;
+
+    const hash_func hash_values = hash_func{};
+
+    std::pair<size_t, uint64_t> index_and_fingerprint(const value_type& val) const {
+        auto [a, b] = hash_values(val);
+        // 0 marks an empty slot
+        uint64_t fp = uint64_t(b) % fp_mask + 1;
+        return {a & (bucket_count - 1), fp};
+    }
+
+    size_t alt_index(size_t i, uint64_t fp) const {
+        // MurmurHash2 constant, as in the reference implementation
+        return (i ^ (fp * 0x5bd1e995)) & (bucket_count - 1);
+    }
+
+    uint64_t get_slot(size_t i, size_t slot) const {
+        uint64_t w = B[i * words_per_bucket + slot / slots_per_word];
+        return (w >> (slot % slots_per_word * fingerprint_bits)) & fp_mask;
+    }
+
+    void set_slot(size_t i, size_t slot, uint64_t fp) {
+        uint64_t& w = B[i * words_per_bucket + slot / slots_per_word];
+        size_t shift = slot % slots_per_word * fingerprint_bits;
+        w = (w & ~(fp_mask << shift)) | (fp << shift);
+    }
+
+    // Looks for fp in all lanes of the bucket's words at once
+    // https://graphics.stanford.edu/~seander/bithacks.html#ValueInWord
+    bool contains(size_t i, uint64_t fp) const {
+        constexpr uint64_t low = ~uint64_t(0) / fp_mask;
+        constexpr uint64_t high = low << (fingerprint_bits - 1);
+        for (size_t w = 0; w < words_per_bucket; ++w) {
+            uint64_t x = B[i * words_per_bucket + w] ^ (fp * low);
+            if ((x - low) & ~x & high)
+                return true;
+        }
+        return false;
+    }
+
+    bool insert(size_t i, uint64_t fp) {
+        for (size_t slot = 0; slot < bucket_size; ++slot)
+            if (get_slot(i, slot) == 0) {
+                set_slot(i, slot, fp);
+                return true;
+            }
+        return false;
+    }
+
+    bool erase(size_t i, uint64_t fp) {
+        for (size_t slot = 0; slot < bucket_size; ++slot)
+            if (get_slot(i, slot) == fp) {
+                set_slot(i, slot, 0);
+                return true;
+            }
+        return false;
+    }
+};
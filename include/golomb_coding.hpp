@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+// Streaming Golomb-Rice coding of non negative integers. A value v is
+// written as v >> r in unary, ones ended by a zero, followed by the low r
+// bits of v. Bits are packed least significant first into 64 bit words in
+// native byte order, and words go through a fixed size chunk so neither
+// side ever holds more than a chunk of the stream. The reader is told how
+// many words the code takes and reads no further, so the stream may go on
+// with other data.
+
+inline uint64_t low_bits_mask(size_t count) {
+    return count >= 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+}
+
+// Length in bits of the code rice_writer::write emits for value.
+inline uint64_t rice_code_bits(uint64_t value, size_t r) {
+    return (value >> r) + 1 + r;
+}
+
+class rice_writer {
+    std::ostream& os;
+    size_t rice_bits;
+    std::vector<uint64_t> chunk;
+    size_t chunk_used = 0;
+    uint64_t acc = 0;
+    size_t acc_used = 0;
+    size_t words_written = 0;
+
+    void push(uint64_t word) {
+        chunk[chunk_used++] = word;
+        if (chunk_used == chunk.size())
+            flush_chunk();
+    }
+
+    void flush_chunk() {
+        os.write(reinterpret_cast<const char*>(chunk.data()), chunk_used * sizeof(uint64_t));
+        words_written += chunk_used;
+        chunk_used = 0;
+    }
+
+  public:
+    rice_writer(std::ostream& out, size_t r, size_t chunk_words = 8192)
+        : os(out), rice_bits(r), chunk(chunk_words) {}
+
+    // Writes the count low bits of value.
+    void write_bits(uint64_t value, size_t count) {
+        if (count == 0)
+            return;
+        acc |= value << acc_used;
+        if (acc_used + count >= 64) {
+            push(acc);
+            acc = acc_used == 0 ? 0 : value >> (64 - acc_used);
+            acc_used = acc_used + count - 64;
+        } else {
+            acc_used += count;
+        }
+    }
+
+    void write(uint64_t value) {
+        uint64_t q = value >> rice_bits;
+        for (; q >= 63; q -= 63)
+            write_bits(low_bits_mask(63), 63);
+        // q ones and the terminating zero
+        write_bits(low_bits_mask(q), q + 1);
+        write_bits(value & low_bits_mask(rice_bits), rice_bits);
+    }
+
+    // Pads the last word with zeroes and writes out what is buffered.
+    void finish() {
+        if (acc_used > 0) {
+            push(acc);
+            acc = 0;
+            acc_used = 0;
+        }
+        flush_chunk();
+    }
+
+    size_t bytes_written() const { return words_written * sizeof(uint64_t); }
+};
+
+class rice_reader {
+    std::istream& is;
+    size_t rice_bits;
+    std::vector<uint64_t> chunk;
+    size_t chunk_pos = 0;
+    size_t chunk_size = 0;
+    uint64_t words_left;
+    uint64_t cur = 0;
+    size_t avail = 0;
+    bool failed = false;
+
+    uint64_t fetch() {
+        if (chunk_pos == chunk_size) {
+            size_t count = std::min<uint64_t>(chunk.size(), words_left);
+            is.read(reinterpret_cast<char*>(chunk.data()), count * sizeof(uint64_t));
+            chunk_size = is.gcount() / sizeof(uint64_t);
+            chunk_pos = 0;
+            words_left -= chunk_size;
+            if (chunk_size == 0) {
+                failed = true;
+                return 0;
+            }
+        }
+        return chunk[chunk_pos++];
+    }
+
+    void consume(size_t count) {
+        cur = count >= 64 ? 0 : cur >> count;
+        avail -= count;
+    }
+
+  public:
+    // Reads a code of word_count words.
+    rice_reader(std::istream& in, size_t r, uint64_t word_count, size_t chunk_words = 8192)
+        : is(in), rice_bits(r), chunk(chunk_words), words_left(word_count) {}
+
+    uint64_t read_bits(size_t count) {
+        if (count <= avail) {
+            uint64_t v = cur & low_bits_mask(count);
+            consume(count);
+            return v;
+        }
+        uint64_t v = cur;
+        size_t have = avail;
+        size_t need = count - have;
+        cur = fetch();
+        avail = 64;
+        v |= (cur & low_bits_mask(need)) << have;
+        consume(need);
+        return v;
+    }
+
+    uint64_t read() {
+        uint64_t q = 0;
+        for (;;) {
+            if (avail == 0) {
+                cur = fetch();
+                avail = 64;
+                if (failed)
+                    return 0;
+            }
+            size_t ones = ~cur == 0 ? 64 : __builtin_ctzll(~cur);
+            if (ones < avail) {
+                q += ones;
+                consume(ones + 1);
+                break;
+            }
+            q += avail;
+            consume(avail);
+        }
+        return (q << rice_bits) | read_bits(rice_bits);
+    }
+
+    // False once a read ran past the end of the code or the stream.
+    bool good() const { return !failed; }
+
+    // True once every word of the code has been read.
+    bool done() const { return words_left == 0 && chunk_pos == chunk_size; }
+};
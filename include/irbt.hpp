@@ -0,0 +1,499 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "common.hpp"
+
+// Header written by IndexRBTree::save ahead of the node array.
+struct index_rbtree_header {
+    static constexpr char tree_magic[8] = {'I', 'D', 'X', 'R', 'B', 'T', 'R', 'E'};
+    static constexpr uint32_t current_version = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t node_size;
+    uint64_t node_count;
+    uint64_t size;
+    uint32_t root;
+    uint32_t free;
+};
+
+// Red black tree whose nodes live in one vector and link to each other by
+// 32 bit indices, the color in the top bit of the parent index. Slot 0 is
+// the black nil sentinel every leaf points to, as in CLRS, and erased slots
+// are chained through their left index for reuse. Holds up to 2^31 - 1
+// keys. Nothing points into the vector, so for trivially copyable values
+// the node array is saved and loaded as is.
+template<typename T, typename Compare = three_way_compare<T>>
+class IndexRBTree {
+  public:
+    using value_type = T;
+    using index_type = uint32_t;
+
+  private:
+    static constexpr index_type nil = 0;
+    static constexpr index_type red_bit = index_type(1) << 31;
+    // nodes read at a time by load
+    static constexpr size_t load_chunk_nodes = 65536;
+
+    struct Node {
+        value_type val;
+        index_type left = nil;
+        index_type right = nil;
+        index_type parent_and_color = nil;
+    };
+
+    std::vector<Node> m_nodes = std::vector<Node>(1);
+    index_type m_root = nil;
+    index_type m_free = nil;
+    size_t m_size = 0;
+
+    Compare compare;
+
+    index_type& left(index_type i) { return m_nodes[i].left; }
+    index_type& right(index_type i) { return m_nodes[i].right; }
+
+    index_type parent(index_type i) const {
+        return m_nodes[i].parent_and_color & ~red_bit;
+    }
+
+    void set_parent(index_type i, index_type p) {
+        auto& pc = m_nodes[i].parent_and_color;
+        pc = (pc & red_bit) | p;
+    }
+
+    bool is_red(index_type i) const { return m_nodes[i].parent_and_color & red_bit; }
+
+    void set_red(index_type i, bool red) {
+        auto& pc = m_nodes[i].parent_and_color;
+        pc = red ? pc | red_bit : pc & ~red_bit;
+    }
+
+    index_type allocate(const value_type& val) {
+        index_type i = m_free;
+        if (i != nil) {
+            m_free = m_nodes[i].left;
+            m_nodes[i] = Node{val};
+        } else {
+            i = m_nodes.size();
+            m_nodes.push_back(Node{val});
+        }
+        set_red(i, true);
+        return i;
+    }
+
+    void deallocate(index_type i) {
+        m_nodes[i] = Node{};
+        m_nodes[i].left = m_free;
+        m_free = i;
+    }
+
+    index_type find_node(const value_type& val) const {
+        index_type i = m_root;
+        while (i != nil) {
+            int c = compare(val, m_nodes[i].val);
+            if (c == 0)
+                break;
+            i = c < 0 ? m_nodes[i].left : m_nodes[i].right;
+        }
+        return i;
+    }
+
+    index_type minimum(index_type i) const {
+        while (m_nodes[i].left != nil)
+            i = m_nodes[i].left;
+        return i;
+    }
+
+    void left_rotate(index_type x) {
+        index_type y = right(x);
+        right(x) = left(y);
+        if (left(y) != nil)
+            set_parent(left(y), x);
+        replace_child(parent(x), x, y);
+        left(y) = x;
+        set_parent(x, y);
+    }
+
+    void right_rotate(index_type y) {
+        index_type x = left(y);
+        left(y) = right(x);
+        if (right(x) != nil)
+            set_parent(right(x), y);
+        replace_child(parent(y), y, x);
+        right(x) = y;
+        set_parent(y, x);
+    }
+
+    // Puts v where u was under p, u's parent.
+    void replace_child(index_type p, index_type u, index_type v) {
+        if (p == nil)
+            m_root = v;
+        else if (u == left(p))
+            left(p) = v;
+        else
+            right(p) = v;
+        set_parent(v, p);
+    }
+
+    void insert_fixup(index_type z) {
+        while (is_red(parent(z))) {
+            index_type p = parent(z);
+            index_type g = parent(p);
+            if (p == left(g)) {
+                index_type y = right(g);
+                if (is_red(y)) {
+                    set_red(p, false);
+                    set_red(y, false);
+                    set_red(g, true);
+                    z = g;
+                    continue;
+                }
+                if (z == right(p)) {
+                    z = p;
+                    left_rotate(z);
+                    p = parent(z);
+                }
+                set_red(p, false);
+                set_red(g, true);
+                right_rotate(g);
+            } else {
+                index_type y = left(g);
+                if (is_red(y)) {
+                    set_red(p, false);
+                    set_red(y, false);
+                    set_red(g, true);
+                    z = g;
+                    continue;
+                }
+                if (z == left(p)) {
+                    z = p;
+                    right_rotate(z);
+                    p = parent(z);
+                }
+                set_red(p, false);
+                set_red(g, true);
+                left_rotate(g);
+            }
+        }
+        set_red(m_root, false);
+    }
+
+    void erase_node(index_type z) {
+        index_type y = z;
+        bool removed_red = is_red(y);
+        index_type x;
+        if (left(z) == nil) {
+            x = right(z);
+            replace_child(parent(z), z, x);
+        } else if (right(z) == nil) {
+            x = left(z);
+            replace_child(parent(z), z, x);
+        } else {
+            // z's successor takes z's place and color
+            y = minimum(right(z));
+            removed_red = is_red(y);
+            x = right(y);
+            if (parent(y) == z) {
+                set_parent(x, y);
+            } else {
+                replace_child(parent(y), y, x);
+                right(y) = right(z);
+                set_parent(right(y), y);
+            }
+            replace_child(parent(z), z, y);
+            left(y) = left(z);
+            set_parent(left(y), y);
+            set_red(y, is_red(z));
+        }
+        if (!removed_red)
+            erase_fixup(x);
+        deallocate(z);
+        // the sentinel may have picked up a parent above
+        m_nodes[nil].parent_and_color = nil;
+        --m_size;
+    }
+
+    void erase_fixup(index_type x) {
+        while (x != m_root && !is_red(x)) {
+            index_type p = parent(x);
+            if (x == left(p)) {
+                index_type w = right(p);
+                if (is_red(w)) {
+                    set_red(w, false);
+                    set_red(p, true);
+                    left_rotate(p);
+                    w = right(p);
+                }
+                if (!is_red(left(w)) && !is_red(right(w))) {
+                    set_red(w, true);
+                    x = p;
+                } else {
+                    if (!is_red(right(w))) {
+                        set_red(left(w), false);
+                        set_red(w, true);
+                        right_rotate(w);
+                        w = right(p);
+                    }
+                    set_red(w, is_red(p));
+                    set_red(p, false);
+                    set_red(right(w), false);
+                    left_rotate(p);
+                    x = m_root;
+                }
+            } else {
+                index_type w = left(p);
+                if (is_red(w)) {
+                    set_red(w, false);
+                    set_red(p, true);
+                    right_rotate(p);
+                    w = left(p);
+                }
+                if (!is_red(left(w)) && !is_red(right(w))) {
+                    set_red(w, true);
+                    x = p;
+                } else {
+                    if (!is_red(left(w))) {
+                        set_red(right(w), false);
+                        set_red(w, true);
+                        left_rotate(w);
+                        w = left(p);
+                    }
+                    set_red(w, is_red(p));
+                    set_red(p, false);
+                    set_red(left(w), false);
+                    right_rotate(p);
+                    x = m_root;
+                }
+            }
+        }
+        set_red(x, false);
+    }
+
+    // True if nil is a bare black sentinel and the links form one tree of
+    // m_size nodes under m_root, with every other slot on the free list.
+    bool well_formed() const {
+        const Node& sentinel = m_nodes[nil];
+        if (sentinel.left != nil || sentinel.right != nil || sentinel.parent_and_color != nil)
+            return false;
+
+        size_t count = m_nodes.size();
+        std::vector<bool> seen(count);
+        seen[nil] = true;
+        size_t reached = 0;
+        std::vector<index_type> pending;
+        if (m_root != nil) {
+            if (parent(m_root) != nil)
+                return false;
+            seen[m_root] = true;
+            pending.push_back(m_root);
+        }
+        while (!pending.empty()) {
+            index_type i = pending.back();
+            pending.pop_back();
+            ++reached;
+            for (index_type child : {m_nodes[i].left, m_nodes[i].right}) {
+                if (child == nil)
+                    continue;
+                if (child >= count || seen[child] || parent(child) != i)
+                    return false;
+                seen[child] = true;
+                pending.push_back(child);
+            }
+        }
+        if (reached != m_size)
+            return false;
+
+        for (index_type i = m_free; i != nil; i = m_nodes[i].left) {
+            if (i >= count || seen[i])
+                return false;
+            seen[i] = true;
+            ++reached;
+        }
+        return reached + 1 == count;
+    }
+
+    // True if the root is black, no red node has a red child and every
+    // path down to nil passes as many black nodes. Needs well_formed links.
+    bool colors_hold() const {
+        if (is_red(m_root))
+            return false;
+        size_t path_blacks = 0;
+        bool first_path = true;
+        std::vector<std::pair<index_type, size_t>> pending = {{m_root, 0}};
+        while (!pending.empty()) {
+            auto [i, blacks] = pending.back();
+            pending.pop_back();
+            if (i == nil) {
+                if (first_path)
+                    path_blacks = blacks;
+                else if (blacks != path_blacks)
+                    return false;
+                first_path = false;
+                continue;
+            }
+            const Node& node = m_nodes[i];
+            if (is_red(i) && (is_red(node.left) || is_red(node.right)))
+                return false;
+            pending.push_back({node.left, blacks + !is_red(i)});
+            pending.push_back({node.right, blacks + !is_red(i)});
+        }
+        return true;
+    }
+
+    // True if an in order walk meets the values in order. Needs
+    // well_formed links.
+    bool ordered() const {
+        std::vector<index_type> pending;
+        index_type prev = nil;
+        for (index_type i = m_root; i != nil || !pending.empty();) {
+            if (i != nil) {
+                pending.push_back(i);
+                i = m_nodes[i].left;
+                continue;
+            }
+            i = pending.back();
+            pending.pop_back();
+            if (prev != nil && compare(m_nodes[prev].val, m_nodes[i].val) > 0)
+                return false;
+            prev = i;
+            i = m_nodes[i].right;
+        }
+        return true;
+    }
+
+  public:
+    // Bytes taken by one node, before any memory the value owns.
+    static constexpr size_t node_size = sizeof(Node);
+
+    IndexRBTree() = default;
+
+    explicit IndexRBTree(Compare c) : compare(std::move(c)) {}
+
+    IndexRBTree(std::initializer_list<value_type> vals) {
+        for (auto& val : vals)
+            insert(val);
+    }
+
+    size_t size() const { return m_size; }
+
+    // Checks the links, the red black properties and the order of the
+    // values. Visits every node, load runs it on every tree it reads.
+    bool is_valid() const { return well_formed() && colors_hold() && ordered(); }
+
+    bool empty() const { return m_size == 0; }
+
+    void clear() {
+        m_nodes.assign(1, Node{});
+        m_root = nil;
+        m_free = nil;
+        m_size = 0;
+    }
+
+    // Bytes of node storage held by the tree.
+    size_t get_memory_usage() const { return m_nodes.capacity() * sizeof(Node); }
+
+    bool contains(const value_type& val) const {
+        return find_node(val) != nil;
+    }
+
+    // Fails once the tree holds 2^31 - 1 keys.
+    bool insert(const value_type& val) {
+        if (m_free == nil && m_nodes.size() >= red_bit)
+            return false;
+
+        index_type p = nil;
+        index_type i = m_root;
+        bool go_left = false;
+        while (i != nil) {
+            p = i;
+            go_left = compare(val, m_nodes[i].val) < 0;
+            i = go_left ? m_nodes[i].left : m_nodes[i].right;
+        }
+
+        index_type z = allocate(val);
+        set_parent(z, p);
+        if (p == nil)
+            m_root = z;
+        else if (go_left)
+            left(p) = z;
+        else
+            right(p) = z;
+
+        insert_fixup(z);
+        ++m_size;
+        return true;
+    }
+
+    // Removes one occurrence of val. At most three rotations.
+    bool erase(const value_type& val) {
+        index_type z = find_node(val);
+        if (z == nil)
+            return false;
+        erase_node(z);
+        return true;
+    }
+
+    // Writes the header and the node array, free slots included.
+    bool save(std::ostream& os) const {
+        static_assert(std::is_trivially_copyable_v<value_type>,
+                      "only trivially copyable values can be saved as is");
+
+        index_rbtree_header header = {};
+        std::memcpy(header.magic, header.tree_magic, sizeof(header.magic));
+        header.version = header.current_version;
+        header.node_size = sizeof(Node);
+        header.node_count = m_nodes.size();
+        header.size = m_size;
+        header.root = m_root;
+        header.free = m_free;
+
+        os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        os.write(reinterpret_cast<const char*>(m_nodes.data()), m_nodes.size() * sizeof(Node));
+        return os.good();
+    }
+
+    // Reads a tree written by save, straight into the node array, and
+    // hands it out only if is_valid. The tree orders values with c, which
+    // must order them as the saved one did.
+    static std::optional<IndexRBTree> load(std::istream& is, Compare c = Compare()) {
+        static_assert(std::is_trivially_copyable_v<value_type>,
+                      "only trivially copyable values can be loaded as is");
+
+        index_rbtree_header header;
+        if (!is.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            return std::nullopt;
+        if (std::memcmp(header.magic, header.tree_magic, sizeof(header.magic)) != 0
+            || header.version != header.current_version
+            || header.node_size != sizeof(Node)
+            || header.node_count == 0
+            || header.node_count > red_bit
+            || header.root >= header.node_count
+            || header.free >= header.node_count)
+            return std::nullopt;
+
+        // the array grows with the nodes actually read, a short stream
+        // cannot make it allocate all of the node_count it claims
+        IndexRBTree t(std::move(c));
+        for (size_t read = 0; read < header.node_count;) {
+            size_t count = std::min<uint64_t>(load_chunk_nodes, header.node_count - read);
+            t.m_nodes.resize(read + count);
+            if (!is.read(reinterpret_cast<char*>(t.m_nodes.data() + read), count * sizeof(Node)))
+                return std::nullopt;
+            read += count;
+        }
+        t.m_root = header.root;
+        t.m_free = header.free;
+        t.m_size = header.size;
+        if (!t.is_valid())
+            return std::nullopt;
+        return t;
+    }
+};
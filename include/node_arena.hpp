@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Destroys a node in place and leaves its memory to the arena it came from.
+template <typename Node>
+struct node_deleter {
+    void operator()(Node* node) const { node->~Node(); }
+};
+
+// Slab allocator for tree nodes. Nodes are carved out of chunks that double
+// in size up to max_chunk_nodes, so consecutive inserts land next to each
+// other instead of wherever malloc puts them. Slots of recycled nodes are
+// kept on a free list and handed out first. Chunks are only returned all at
+// once, by clear or when the arena is destroyed, so every node must be
+// gone by then.
+template <typename Node>
+class node_arena {
+    union slot {
+        slot* next;
+        alignas(Node) unsigned char bytes[sizeof(Node)];
+    };
+
+    static constexpr size_t min_chunk_nodes = 32;
+    static constexpr size_t max_chunk_nodes = 65536;
+
+    std::vector<std::unique_ptr<slot[]>> chunks;
+    size_t chunk_nodes = 0;
+    size_t chunk_used = 0;
+    size_t slot_count = 0;
+    slot* free_list = nullptr;
+
+    void* allocate() {
+        if (free_list != nullptr) {
+            slot* s = free_list;
+            free_list = s->next;
+            return s;
+        }
+        if (chunk_used == chunk_nodes) {
+            chunk_nodes = std::clamp(chunk_nodes * 2, min_chunk_nodes, max_chunk_nodes);
+            chunks.emplace_back(new slot[chunk_nodes]);
+            chunk_used = 0;
+            slot_count += chunk_nodes;
+        }
+        return &chunks.back()[chunk_used++];
+    }
+
+    void deallocate(Node* node) {
+        slot* s = reinterpret_cast<slot*>(node);
+        s->next = free_list;
+        free_list = s;
+    }
+
+  public:
+    using unique_ptr = std::unique_ptr<Node, node_deleter<Node>>;
+
+    // count contiguous slots handed out by allocate_block
+    class block {
+        slot* first = nullptr;
+        friend class node_arena;
+        explicit block(slot* s) : first(s) {}
+
+      public:
+        block() = default;
+
+        // Builds the node in slot i. Touches nothing but that slot, so
+        // separate threads may fill distinct slots of a block.
+        template <typename... Args>
+        unique_ptr make(size_t i, Args&&... args) const {
+            return unique_ptr(new (&first[i]) Node(std::forward<Args>(args)...));
+        }
+    };
+
+    node_arena() = default;
+    node_arena(const node_arena&) = delete;
+    node_arena& operator=(const node_arena&) = delete;
+
+    node_arena(node_arena&& other) noexcept { swap(other); }
+
+    node_arena& operator=(node_arena&& other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    void swap(node_arena& other) noexcept {
+        std::swap(chunks, other.chunks);
+        std::swap(chunk_nodes, other.chunk_nodes);
+        std::swap(chunk_used, other.chunk_used);
+        std::swap(slot_count, other.slot_count);
+        std::swap(free_list, other.free_list);
+    }
+
+    template <typename... Args>
+    unique_ptr make(Args&&... args) {
+        return unique_ptr(new (allocate()) Node(std::forward<Args>(args)...));
+    }
+
+    // Takes count contiguous slots in a chunk of their own, for trees that
+    // are built all at once.
+    block allocate_block(size_t count) {
+        std::unique_ptr<slot[]> chunk(new slot[count]);
+        slot* first = chunk.get();
+        // keep the chunk being carved up by allocate at the back
+        if (chunks.empty()) {
+            chunks.push_back(std::move(chunk));
+            chunk_nodes = chunk_used = count;
+        } else {
+            chunks.insert(chunks.end() - 1, std::move(chunk));
+        }
+        slot_count += count;
+        return block(first);
+    }
+
+    // Destroys a single node, which must not own children any more, and
+    // puts its slot up for reuse.
+    void recycle(unique_ptr node) {
+        Node* raw = node.release();
+        raw->~Node();
+        deallocate(raw);
+    }
+
+    // Destroys a whole tree without recursing, so degenerate trees cannot
+    // overflow the stack. Trees of trivially destructible values are just
+    // dropped, their memory goes away with the chunks.
+    void release_tree(unique_ptr root) {
+        if constexpr (std::is_trivially_destructible_v<decltype(Node::val)>) {
+            root.release();
+        } else {
+            // rotate left children up until there are none, then peel the
+            // root off the resulting right spine
+            while (root != nullptr) {
+                if (root->left != nullptr) {
+                    auto left = std::move(root->left);
+                    root->left = std::move(left->right);
+                    left->right = std::move(root);
+                    root = std::move(left);
+                } else {
+                    auto right = std::move(root->right);
+                    recycle(std::move(root));
+                    root = std::move(right);
+                }
+            }
+        }
+    }
+
+    // Returns every chunk. Only valid once all nodes have been released.
+    void clear() {
+        chunks.clear();
+        chunk_nodes = 0;
+        chunk_used = 0;
+        slot_count = 0;
+        free_list = nullptr;
+    }
+
+    size_t get_chunk_count() const { return chunks.size(); }
+
+    size_t get_memory_usage() const { return slot_count * sizeof(slot); }
+};
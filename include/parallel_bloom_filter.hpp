@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "bloom_filter.hpp"
+
+// Builds one bloom_filter from [first, last) using the given number of
+// threads. The range is cut into one contiguous slice per thread, every
+// thread fills a private filter of the same shape with the add_many
+// pipeline, and the private filters are then merged into the result.
+template <typename value_type,
+          typename hash_func = Hasher<value_type>,
+          typename Iter>
+bloom_filter<value_type, hash_func>
+parallel_build(size_t n, double p, Iter first, Iter last,
+               unsigned threads = std::thread::hardware_concurrency()) {
+    using filter = bloom_filter<value_type, hash_func>;
+
+    threads = std::max(1u, threads);
+    size_t count = std::distance(first, last);
+    size_t slice = (count + threads - 1) / threads;
+
+    std::vector<filter> partials(threads, filter(n, p));
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        size_t begin = std::min(count, t * slice);
+        size_t end = std::min(count, begin + slice);
+        Iter from = std::next(first, begin);
+        Iter to = std::next(first, end);
+        workers.emplace_back([&partials, t, from, to]() {
+            partials[t].add_many(from, to);
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+
+    for (unsigned t = 1; t < threads; ++t)
+        partials[0].merge_union(partials[t]);
+    return std::move(partials[0]);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "bloom_filter.hpp"
+
+// Bloom filter whose m bits are split into k word aligned slices of m / k
+// bits, probe i landing in slice i. No two probes of a key share a slice
+// and every probe index is computed independently of the others, so with
+// AVX2 test computes and gathers four probes per instruction instead of
+// walking them one by one. Probes are reduced onto a slice with a 32 bit
+// multiply-shift, which caps slices below 2^32 bits, the constructor
+// throws std::invalid_argument for filters that would need bigger ones.
+
+template <typename value_type,
+          typename hash_func = Hasher<value_type>>
+struct partitioned_bloom_filter {
+
+    using container = std::vector<uint64_t>;
+
+    partitioned_bloom_filter(size_t n, double p) {
+        auto [m, k] = bloom_filter<value_type, hash_func>::optimal_shape(n, p);
+
+        hash_func_count = k;
+        slice_words = (m + 64 * k - 1) / (64 * k);
+        slice_bits = slice_words * 64;
+        // the AVX2 multiply only sees the low 32 bits of slice_bits
+        if (slice_bits >= uint64_t(1) << 32)
+            throw std::invalid_argument("partitioned_bloom_filter: slices past 2^32 bits");
+        bit_count = slice_bits * k;
+        B.resize(slice_words * k);
+    }
+
+    void add(const value_type& val) {
+        auto [a, b] = hash_values(val);
+        for (size_t i = 0; i < hash_func_count; ++i) {
+            size_t pos = slice_pos(i, a, b);
+            B[i * slice_words + pos / 64] |= uint64_t(1) << (pos % 64);
+        }
+    }
+
+    void add(const std::initializer_list<value_type>& vals) {
+        for (const auto& val : vals)
+            add(val);
+    }
+
+    bool test(const value_type& val) const {
+        auto [a, b] = hash_values(val);
+        size_t i = 0;
+#ifdef __AVX2__
+        const __m256i step = _mm256_set1_epi64x(4);
+        const __m256i hash_a = _mm256_set1_epi64x(uint32_t(a));
+        const __m256i hash_b = _mm256_set1_epi64x(uint32_t(b));
+        const __m256i low32 = _mm256_set1_epi64x(0xffffffff);
+        const __m256i slice_len = _mm256_set1_epi64x(slice_bits);
+        const __m256i slice_size = _mm256_set1_epi64x(slice_words);
+        const __m256i one = _mm256_set1_epi64x(1);
+        const __m256i bit_mask = _mm256_set1_epi64x(63);
+        __m256i index = _mm256_setr_epi64x(0, 1, 2, 3);
+        for (; i + 4 <= hash_func_count; i += 4) {
+            // same arithmetic as slice_pos, four slices at a time
+            __m256i h = _mm256_and_si256(
+                _mm256_add_epi64(hash_a, _mm256_mul_epu32(index, hash_b)), low32);
+            __m256i pos = _mm256_srli_epi64(_mm256_mul_epu32(h, slice_len), 32);
+            __m256i word = _mm256_add_epi64(_mm256_mul_epu32(index, slice_size),
+                                            _mm256_srli_epi64(pos, 6));
+            __m256i w = _mm256_i64gather_epi64(
+                reinterpret_cast<const long long*>(B.data()), word, 8);
+            __m256i bit = _mm256_and_si256(
+                _mm256_srlv_epi64(w, _mm256_and_si256(pos, bit_mask)), one);
+            if (_mm256_movemask_pd(_mm256_castsi256_pd(
+                    _mm256_cmpeq_epi64(bit, _mm256_setzero_si256()))) != 0)
+                return false;
+            index = _mm256_add_epi64(index, step);
+        }
+#endif
+        for (; i < hash_func_count; ++i) {
+            size_t pos = slice_pos(i, a, b);
+            if ((B[i * slice_words + pos / 64] & (uint64_t(1) << (pos % 64))) == 0)
+                return false;
+        }
+        return true;
+    }
+
+    size_t get_bit_count() { return bit_count; }
+
+    size_t get_hash_func_count() { return hash_func_count; }
+
+    size_t get_slice_bit_count() { return slice_bits; }
+
+  private:
+    size_t bit_count;
+    size_t hash_func_count;
+    size_t slice_words;
+    size_t slice_bits;
+    container B;
+
+    const hash_func hash_values = hash_func{};
+
+    size_t slice_pos(size_t i, uint32_t a, uint32_t b) const {
+        uint32_t h = a + uint32_t(i) * b;
+        return (uint64_t(h) * slice_bits) >> 32;
+    }
+};
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <optional>
+#include <thread>
+#include <utility>
 #include "common.hpp"
+#include "node_arena.hpp"
 
 // 1. a node is red or black 
 //
@@ -18,28 +23,43 @@
 // descendant leaves contain the same number of black
 // nodes
 
-template<typename value_type>
+template<typename T, typename Compare = three_way_compare<T>>
 class RBTree {
+  public:
+    using value_type = T;
+
+  private:
     struct Node;
 
     using raw_ptr    = Node*;
-    using unique_ptr = std::unique_ptr<Node>;
+    using unique_ptr = typename node_arena<Node>::unique_ptr;
 
     enum class rb_color { BLACK, RED };
+
+    // The color lives in the low bit of the parent pointer, which node
+    // alignment leaves free, so a node is the value and three pointers.
     struct Node {
         value_type val;
-        rb_color color = rb_color::RED;
-        raw_ptr parent = nullptr;
+        tagged_ptr<Node> parent;
         unique_ptr left = nullptr;
         unique_ptr right = nullptr;
-        explicit Node(const value_type& v) : val(v) {}
+        explicit Node(const value_type& v) : val(v) { parent.set_tag(true); }
+
+        rb_color color() const {
+            return parent.tag() ? rb_color::RED : rb_color::BLACK;
+        }
+
+        void set_color(rb_color c) { parent.set_tag(c == rb_color::RED); }
     };
 
+    node_arena<Node> m_nodes;
     unique_ptr m_root;
     size_t m_size = 0;
 
+    Compare compare;
+
     unique_ptr& owner(raw_ptr node) {
-        auto parent = node->parent;
+        raw_ptr parent = node->parent;
         if (parent == nullptr)
             return m_root;
         if (parent->left.get() == node)
@@ -48,10 +68,21 @@ class RBTree {
             return parent->right;
     }
 
-    int black_height(const raw_ptr node) const {
-        return (node->color == rb_color::BLACK) 
-             + black_height(node->left)
-             + black_height(node->right);
+    // Black height of the subtree under node, counting the nil leaves, or
+    // -1 if the subtree breaks properties 4 or 5, has a node whose parent
+    // link is not parent, or goes deeper than max_depth.
+    int black_height(raw_ptr node, raw_ptr parent, size_t max_depth) const {
+        if (node == nullptr)
+            return 1;
+        if (max_depth == 0 || node->parent != parent)
+            return -1;
+        if (!is_black(node) && !(is_black(node->left.get()) && is_black(node->right.get())))
+            return -1;
+        int left = black_height(node->left.get(), node, max_depth - 1);
+        int right = black_height(node->right.get(), node, max_depth - 1);
+        if (left < 0 || left != right)
+            return -1;
+        return left + is_black(node);
     }
 
     void left_rotate(unique_ptr& x) {
@@ -122,16 +153,16 @@ class RBTree {
 
     void insert_fixup(raw_ptr node) {
         raw_ptr p = parent(node);
-        // if (!p || (p->color == rb_color::BLACK)
-        //     return;
+        if (p == nullptr || p->color() == rb_color::BLACK)
+            return;
         raw_ptr y = uncle(node);
 
-        if (y && y->color == rb_color::RED) {
-            parent(node)->color = rb_color::BLACK;
-            uncle(node)->color = rb_color::BLACK;
-            grandparent(node)->color = rb_color::RED;
+        if (y && y->color() == rb_color::RED) {
+            parent(node)->set_color(rb_color::BLACK);
+            uncle(node)->set_color(rb_color::BLACK);
+            grandparent(node)->set_color(rb_color::RED);
             insert_fixup(grandparent(node));
-        } else if (p && p->color == rb_color::RED /* and y is black*/) {
+        } else {
             if (is_right_child(node) && is_left_child(p)) {
                 left_rotate(owner(p));
                 node = node->left.get();
@@ -139,40 +170,301 @@ class RBTree {
                 right_rotate(owner(p));
                 node = node->right.get();
             }
+            p = parent(node);
             raw_ptr g = grandparent(node);
             if (node == p->left.get())
                 right_rotate(owner(g));
             else
                 left_rotate(owner(g));
-            p->color = rb_color::BLACK;
-            g->color = rb_color::RED;
+            p->set_color(rb_color::BLACK);
+            g->set_color(rb_color::RED);
         }
     }
 
-    raw_ptr find(const value_type& val) const {
+    raw_ptr find_node(const value_type& val) const {
         auto node = m_root.get();
-        while (node != nullptr && val != node->val)
-            if (val < node->val) node = node->left.get();
-            else                 node = node->right.get();
+        while (node != nullptr) {
+            int c = compare(val, node->val);
+            if (c == 0)
+                break;
+            node = c < 0 ? node->left.get() : node->right.get();
+        }
+        return node;
+    }
+
+    static bool is_black(raw_ptr node) {
+        return node == nullptr || node->color() == rb_color::BLACK;
+    }
+
+    static raw_ptr minimum(raw_ptr node) {
+        while (node->left != nullptr)
+            node = node->left.get();
         return node;
     }
 
-    // https://youtu.be/JfmTagWcqoE?t=1122
-    void release_subtree(unique_ptr n) {
-        while (n->left) {
-            auto leaf = std::move(n->left);
-            while(leaf->left)
-                leaf = std::move(leaf->left);
-            leaf->left.release();
-            leaf->left = std::move(leaf->right);
+    static raw_ptr maximum(raw_ptr node) {
+        while (node->right != nullptr)
+            node = node->right.get();
+        return node;
+    }
+
+    static raw_ptr successor(raw_ptr node) {
+        if (node->right != nullptr)
+            return minimum(node->right.get());
+        while (is_right_child(node))
+            node = node->parent;
+        return node->parent;
+    }
+
+    static raw_ptr predecessor(raw_ptr node) {
+        if (node->left != nullptr)
+            return maximum(node->left.get());
+        while (is_left_child(node))
+            node = node->parent;
+        return node->parent;
+    }
+
+    // First node whose value is not less than val, or with strict set the
+    // first one greater than val.
+    raw_ptr bound(const value_type& val, bool strict) const {
+        raw_ptr node = m_root.get();
+        raw_ptr found = nullptr;
+        while (node != nullptr) {
+            int c = compare(val, node->val);
+            if (c < 0 || (c == 0 && !strict)) {
+                found = node;
+                node = node->left.get();
+            } else {
+                node = node->right.get();
+            }
         }
-        n.release();
+        return found;
     }
 
+    // Unlinks z and returns its successor. A node with two children is
+    // replaced by its successor's node, which takes z's place and color, so
+    // no node other than z changes values and iterators to them stay valid.
+    raw_ptr erase_node(raw_ptr z) {
+        raw_ptr next = successor(z);
+        raw_ptr x;
+        raw_ptr p;
+        bool removed_black;
+        unique_ptr removed;
+        if (z->left == nullptr || z->right == nullptr) {
+            // z has at most one child, which takes its place
+            unique_ptr child = std::move(z->left != nullptr ? z->left : z->right);
+            x = child.get();
+            p = z->parent;
+            removed_black = z->color() == rb_color::BLACK;
+            if (child != nullptr)
+                child->parent = p;
+            removed = std::exchange(owner(z), std::move(child));
+        } else {
+            // the successor y has no left child, its right child takes its
+            // place and y takes z's
+            raw_ptr y = next;
+            unique_ptr child = std::move(y->right);
+            x = child.get();
+            removed_black = y->color() == rb_color::BLACK;
+            unique_ptr moved;
+            if (y->parent == z) {
+                p = y;
+                moved = std::move(z->right);
+                y->right = std::move(child);
+            } else {
+                p = y->parent;
+                if (child != nullptr)
+                    child->parent = p;
+                moved = std::exchange(p->left, std::move(child));
+                y->right = std::move(z->right);
+                y->right->parent = y;
+            }
+            y->left = std::move(z->left);
+            y->left->parent = y;
+            y->parent = z->parent;
+            y->set_color(z->color());
+            removed = std::exchange(owner(z), std::move(moved));
+        }
+        m_nodes.recycle(std::move(removed));
+
+        if (removed_black)
+            erase_fixup(x, p);
+        --m_size;
+        return next;
+    }
+
+    // subtrees smaller than this are not worth a thread of their own
+    static constexpr size_t parallel_build_min = 16384;
+
+    // Builds the subtree of positions [lo, hi) of a sorted range, each node
+    // in the block slot of its position. Nodes at red_depth are red and all
+    // others black, which holds black heights equal since splitting at the
+    // middle fills every level above the last.
+    template<typename RandomIt>
+    unique_ptr build_sorted(RandomIt first, size_t lo, size_t hi, raw_ptr parent,
+                            size_t depth, size_t red_depth,
+                            const typename node_arena<Node>::block& block,
+                            unsigned threads) {
+        if (lo == hi)
+            return nullptr;
+        size_t mid = lo + (hi - lo) / 2;
+        unique_ptr node = block.make(mid, *(first + mid));
+        node->parent = parent;
+        node->set_color(depth == red_depth ? rb_color::RED : rb_color::BLACK);
+
+        if (threads > 1 && hi - lo >= parallel_build_min) {
+            unsigned left_threads = threads / 2;
+            std::thread left([&] {
+                node->left = build_sorted(first, lo, mid, node.get(), depth + 1,
+                                          red_depth, block, left_threads);
+            });
+            node->right = build_sorted(first, mid + 1, hi, node.get(), depth + 1,
+                                       red_depth, block, threads - left_threads);
+            left.join();
+        } else {
+            node->left = build_sorted(first, lo, mid, node.get(), depth + 1,
+                                      red_depth, block, 1);
+            node->right = build_sorted(first, mid + 1, hi, node.get(), depth + 1,
+                                       red_depth, block, 1);
+        }
+        return node;
+    }
+
+    // x carries an extra black, p is its parent. x may be empty, in which
+    // case its sibling is not since the removed node was black.
+    void erase_fixup(raw_ptr x, raw_ptr p) {
+        while (x != m_root.get() && is_black(x)) {
+            if (x == p->left.get()) {
+                raw_ptr w = p->right.get();
+                if (w->color() == rb_color::RED) {
+                    w->set_color(rb_color::BLACK);
+                    p->set_color(rb_color::RED);
+                    left_rotate(owner(p));
+                    w = p->right.get();
+                }
+                if (is_black(w->left.get()) && is_black(w->right.get())) {
+                    w->set_color(rb_color::RED);
+                    x = p;
+                    p = x->parent;
+                } else {
+                    if (is_black(w->right.get())) {
+                        w->left->set_color(rb_color::BLACK);
+                        w->set_color(rb_color::RED);
+                        right_rotate(owner(w));
+                        w = p->right.get();
+                    }
+                    w->set_color(p->color());
+                    p->set_color(rb_color::BLACK);
+                    w->right->set_color(rb_color::BLACK);
+                    left_rotate(owner(p));
+                    x = m_root.get();
+                }
+            } else {
+                raw_ptr w = p->left.get();
+                if (w->color() == rb_color::RED) {
+                    w->set_color(rb_color::BLACK);
+                    p->set_color(rb_color::RED);
+                    right_rotate(owner(p));
+                    w = p->left.get();
+                }
+                if (is_black(w->left.get()) && is_black(w->right.get())) {
+                    w->set_color(rb_color::RED);
+                    x = p;
+                    p = x->parent;
+                } else {
+                    if (is_black(w->left.get())) {
+                        w->right->set_color(rb_color::BLACK);
+                        w->set_color(rb_color::RED);
+                        left_rotate(owner(w));
+                        w = p->left.get();
+                    }
+                    w->set_color(p->color());
+                    p->set_color(rb_color::BLACK);
+                    w->left->set_color(rb_color::BLACK);
+                    right_rotate(owner(p));
+                    x = m_root.get();
+                }
+            }
+        }
+        if (x != nullptr)
+            x->set_color(rb_color::BLACK);
+    }
 
   public:
+    // In order iterator over the values, which cannot be modified in place.
+    // Walks the parent pointers, so a full traversal crosses every edge
+    // twice and increments are amortized O(1). end() keeps the tree to
+    // step back from.
+    class iterator {
+        raw_ptr node = nullptr;
+        const RBTree* tree = nullptr;
+        friend class RBTree;
+        iterator(raw_ptr n, const RBTree* t) : node(n), tree(t) {}
+
+      public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const value_type*;
+        using reference         = const value_type&;
+
+        iterator() = default;
+
+        reference operator*() const { return node->val; }
+        pointer operator->() const { return &node->val; }
+
+        iterator& operator++() {
+            node = successor(node);
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator it = *this;
+            ++*this;
+            return it;
+        }
+
+        iterator& operator--() {
+            node = node == nullptr ? maximum(tree->m_root.get()) : predecessor(node);
+            return *this;
+        }
+
+        iterator operator--(int) {
+            iterator it = *this;
+            --*this;
+            return it;
+        }
+
+        bool operator==(const iterator& other) const { return node == other.node; }
+        bool operator!=(const iterator& other) const { return node != other.node; }
+    };
+
+    // Bytes taken by one node, before any memory the value owns.
+    static constexpr size_t node_size = sizeof(Node);
+
     RBTree() = default;
 
+    explicit RBTree(Compare c) : compare(std::move(c)) {}
+
+    ~RBTree() {
+        m_nodes.release_tree(std::move(m_root));
+    }
+
+    // as BSTree's
+    RBTree(RBTree&& other) noexcept
+        : m_nodes(std::move(other.m_nodes)),
+          m_root(std::move(other.m_root)),
+          m_size(std::exchange(other.m_size, 0)),
+          compare(other.compare) {}
+
+    RBTree& operator=(RBTree&& other) noexcept {
+        m_nodes.swap(other.m_nodes);
+        std::swap(m_root, other.m_root);
+        std::swap(m_size, other.m_size);
+        std::swap(compare, other.compare);
+        return *this;
+    }
+
     RBTree(std::initializer_list<value_type> vals) {
         for (auto& val : vals)
             insert(val);
@@ -180,11 +472,7 @@ class RBTree {
     }
 
     bool contains(const value_type& val) const {
-        raw_ptr node = m_root.get();
-        while (node != nullptr && val != node->val)
-            if (val < node->val) node = node->left.get();
-            else                 node = node->right.get();
-        return node != nullptr;
+        return find_node(val) != nullptr;
     }
 
     bool operator==(const RBTree& other) const {
@@ -197,45 +485,146 @@ class RBTree {
 
     size_t size() { return m_size; }
 
+    // Checks the properties listed above along with the parent links, the
+    // order of the values and the size. Visits every node, it is meant for
+    // tests and debugging.
+    bool is_valid() const {
+        if (!is_black(m_root.get()))
+            return false;
+        // a red black tree of n nodes is at most 2 log2(n + 1) high
+        size_t max_depth = 2;
+        for (size_t n = m_size + 1; n > 1; n >>= 1)
+            max_depth += 2;
+        if (black_height(m_root.get(), nullptr, max_depth) < 0)
+            return false;
+
+        size_t count = 0;
+        for (auto it = begin(); it != end(); ++it, ++count)
+            if (count > 0 && compare(*std::prev(it), *it) > 0)
+                return false;
+        return count == m_size;
+    }
+
+    // Bytes of node storage held by the tree.
+    size_t get_memory_usage() const { return m_nodes.get_memory_usage(); }
+
     bool empty() { return m_size == 0; }
 
     void clear() {
-        m_root.release();
+        m_nodes.release_tree(std::move(m_root));
+        m_nodes.clear();
         m_size = 0;
     }
 
     void insert(const value_type& val) {
         raw_ptr parent = nullptr;
         auto node = m_root.get();
+        bool left = false;
 
         while (node != nullptr) {
             parent = node;
-            if (val < node->val) node = node->left.get();
-            else                 node = node->right.get();
+            left = compare(val, node->val) < 0;
+            node = left ? node->left.get() : node->right.get();
         }
 
         if (parent == nullptr){
-            m_root = std::make_unique<Node>(val);
-            m_root->color = rb_color::BLACK;
+            m_root = m_nodes.make(val);
+            m_root->set_color(rb_color::BLACK);
         }
-        else if (val < parent->val) {
-            parent->left = std::make_unique<Node>(val);
+        else if (left) {
+            parent->left = m_nodes.make(val);
             parent->left->parent = parent;
             insert_fixup(parent->left.get());
         } else {
-            parent->right = std::make_unique<Node>(val);
+            parent->right = m_nodes.make(val);
             parent->right->parent = parent;
             insert_fixup(parent->right.get());
         }
 
-        m_root->color = rb_color::BLACK;
+        m_root->set_color(rb_color::BLACK);
         ++m_size;
     }
 
+    using reverse_iterator = std::reverse_iterator<iterator>;
+
+    iterator begin() const {
+        return iterator(m_root == nullptr ? nullptr : minimum(m_root.get()), this);
+    }
+
+    iterator end() const { return iterator(nullptr, this); }
+
+    reverse_iterator rbegin() const { return reverse_iterator(end()); }
+
+    reverse_iterator rend() const { return reverse_iterator(begin()); }
+
+    // Iterator to an occurrence of val, or end.
+    iterator find(const value_type& val) const { return iterator(find_node(val), this); }
+
+    // First value not less than val.
+    iterator lower_bound(const value_type& val) const {
+        return iterator(bound(val, false), this);
+    }
+
+    // First value greater than val.
+    iterator upper_bound(const value_type& val) const {
+        return iterator(bound(val, true), this);
+    }
+
+    std::pair<iterator, iterator> equal_range(const value_type& val) const {
+        return {lower_bound(val), upper_bound(val)};
+    }
+
+    // Number of values in [lo, hi), O(log n + k) for k values in range.
+    size_t count_range(const value_type& lo, const value_type& hi) const {
+        if (compare(lo, hi) >= 0)
+            return 0;
+        size_t count = 0;
+        for (auto it = lower_bound(lo), last = lower_bound(hi); it != last; ++it)
+            ++count;
+        return count;
+    }
+
+    // Replaces the contents with a range already sorted by Compare, in
+    // linear time and without a single comparison. Subtrees are built on
+    // up to threads threads, nodes are laid out in order in one block.
+    template<typename RandomIt>
+    void assign_sorted(RandomIt first, RandomIt last, unsigned threads = 1) {
+        clear();
+        size_t n = last - first;
+        if (n == 0)
+            return;
+
+        // depth of the last, possibly partial, level
+        size_t red_depth = 0;
+        while ((size_t(2) << red_depth) <= n)
+            ++red_depth;
+
+        auto block = m_nodes.allocate_block(n);
+        m_root = build_sorted(first, 0, n, nullptr, 0, red_depth, block,
+                              std::max(threads, 1u));
+        m_root->set_color(rb_color::BLACK);
+        m_size = n;
+    }
+
+    // Removes one occurrence of val. At most three rotations.
+    bool erase(const value_type& val) {
+        raw_ptr node = find_node(val);
+        if (node == nullptr)
+            return false;
+        erase_node(node);
+        return true;
+    }
+
+    // Removes the value at pos and returns the iterator to the value after
+    // it. Only iterators to the removed value are invalidated.
+    iterator erase(iterator pos) {
+        return iterator(erase_node(pos.node), this);
+    }
+
     friend std::ostream& operator<<(std::ostream& os, unique_ptr& node) {
         if (node == nullptr)
             return os << "empty";
-        switch (node->color) {
+        switch (node->color()) {
         case rb_color::RED:
             return os << "\033[31m" << node->val << "\033[0m " << node->left
                       << " " << node->right;
@@ -258,7 +647,7 @@ class RBTree {
 
         std::cout << prefix << (is_left ? node->parent->right != nullptr ? "├──" : "└──" : "└──");
 
-        if (node->color == rb_color::RED)
+        if (node->color() == rb_color::RED)
             std::cout << std::setw(2) << "\033[31m " << node->val << "\033[0m\n";
         else
             std::cout << std::setw(2) << node->val << '\n';
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "bloom_filter.hpp"
+
+// A chain of bloom filters for when the set size is not known up front.
+// Once the newest stage holds as many keys as it was sized for, a new one
+// with growth times the capacity and tightening times the false positive
+// rate is appended. The stage rates form a geometric series bounded by p,
+// and since capacities grow geometrically the number of stages, and so the
+// cost of test, grows with the logarithm of the number of keys.
+// Almeida, Baquero, Preguica, Hutchison - Scalable Bloom Filters
+
+template <typename value_type,
+          typename hash_func = Hasher<value_type>>
+struct scalable_bloom_filter {
+
+    using stage = bloom_filter<value_type, hash_func>;
+
+    static constexpr size_t growth = 2;
+    static constexpr double tightening = 0.5;
+
+    // Throws std::invalid_argument for n = 0, no stage could be sized.
+    scalable_bloom_filter(size_t n, double p) : initial_size(n) {
+        if (n == 0)
+            throw std::invalid_argument("scalable_bloom_filter: n must be positive");
+        // p0 + p0 * r + p0 * r^2 + ... = p0 / (1 - r) = p
+        next_fp_prob = p * (1 - tightening);
+        add_stage();
+    }
+
+    void add(const value_type& val) {
+        auto h = stages.back().hash(val);
+        if (test_hashed(h))
+            return;
+        if (stage_size == stage_capacity)
+            add_stage();
+        stages.back().add_hashed(h);
+        ++stage_size;
+        ++m_size;
+    }
+
+    void add(const std::initializer_list<value_type>& vals) {
+        for (auto val : vals)
+            add(val);
+    }
+
+    bool test(const value_type& val) const {
+        return test_hashed(stages.back().hash(val));
+    }
+
+    // Number of distinct keys added, up to false positives.
+    size_t size() const { return m_size; }
+
+    size_t get_stage_count() const { return stages.size(); }
+
+    size_t get_bit_count() {
+        size_t bits = 0;
+        for (auto& s : stages)
+            bits += s.get_bit_count();
+        return bits;
+    }
+
+  private:
+    size_t initial_size;
+    double next_fp_prob;
+    size_t stage_capacity = 0;
+    size_t stage_size = 0;
+    size_t m_size = 0;
+    std::vector<stage> stages;
+
+    void add_stage() {
+        stage_capacity = stages.empty() ? initial_size : stage_capacity * growth;
+        stage_size = 0;
+        stages.emplace_back(stage_capacity, next_fp_prob);
+        next_fp_prob *= tightening;
+    }
+
+    bool test_hashed(typename stage::hash_type h) const {
+        // the newest stages are the largest and hold most of the keys
+        for (auto s = stages.rbegin(); s != stages.rend(); ++s)
+            if (s->test_hashed(h))
+                return true;
+        return false;
+    }
+};
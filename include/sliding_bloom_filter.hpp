@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+
+#include "bloom_filter.hpp"
+
+// Bloom filter over a sliding window, kept as G generations of one
+// bloom_filter each. Keys go into the newest generation and rotate() drops
+// the oldest one, clearing its m / G bits a word at a time and reusing it
+// as the new newest. Calling rotate() every window / G keeps a key visible
+// for between (G - 1) / G and one full window. test hashes the key once
+// and probes every live generation with that hash.
+
+template <typename value_type,
+          typename hash_func = Hasher<value_type>>
+struct sliding_bloom_filter {
+
+    using generation = bloom_filter<value_type, hash_func>;
+
+    // n keys per window with a false positive rate of p, split evenly over
+    // the given number of generations. Throws std::invalid_argument when n
+    // or generations is 0.
+    sliding_bloom_filter(size_t n, double p, size_t generations)
+        : gens(generations, first_generation(n, p, generations)) {}
+
+    void add(const value_type& val) {
+        gens[newest].add_hashed(gens[newest].hash(val));
+    }
+
+    void add(const std::initializer_list<value_type>& vals) {
+        for (const auto& val : vals)
+            add(val);
+    }
+
+    bool test(const value_type& val) const {
+        auto h = gens[newest].hash(val);
+        for (size_t i = 0; i < gens.size(); ++i)
+            if (gens[(newest + gens.size() - i) % gens.size()].test_hashed(h))
+                return true;
+        return false;
+    }
+
+    // Ages out the oldest generation.
+    void rotate() {
+        newest = (newest + 1) % gens.size();
+        gens[newest].clear();
+    }
+
+    size_t get_generation_count() const { return gens.size(); }
+
+    size_t get_bit_count() {
+        return gens.size() * gens[0].get_bit_count();
+    }
+
+  private:
+    std::vector<generation> gens;
+    size_t newest = 0;
+
+    static generation first_generation(size_t n, double p, size_t generations) {
+        if (n == 0 || generations == 0)
+            throw std::invalid_argument("sliding_bloom_filter: n and generations must be positive");
+        return generation((n + generations - 1) / generations, p / generations);
+    }
+};
@@ -2,16 +2,19 @@
 
 #include "bst.hpp"
 #include "common.hpp"
+#include "node_arena.hpp"
 #include <iomanip>
 #include <iostream>
 #include <memory>
 #include <optional>
 
-template <typename value_type> class STree : private BSTree<value_type> {
+template <typename value_type,
+          typename Compare = three_way_compare<value_type>>
+class STree : private BSTree<value_type, Compare> {
     struct Node;
 
     using raw_ptr = Node *;
-    using unique_ptr = std::unique_ptr<Node>;
+    using unique_ptr = typename node_arena<Node>::unique_ptr;
     
     struct Node {
         value_type val;
@@ -21,9 +24,12 @@ template <typename value_type> class STree : private BSTree<value_type> {
         explicit Node(const value_type &v) : val(v) {}
     };
 
+    node_arena<Node> m_nodes;
     unique_ptr m_root;
     size_t m_size = 0;
 
+    Compare compare;
+
     unique_ptr &owner(raw_ptr node) {
         auto parent = node->parent;
         if (parent == nullptr)
@@ -148,23 +154,29 @@ template <typename value_type> class STree : private BSTree<value_type> {
         }
     }
 
-    // https://youtu.be/JfmTagWcqoE?t=1122
-    void release_subtree(unique_ptr n) {
-        while (n->left) {
-            auto leaf = std::move(n->left);
-            while(leaf->left)
-                leaf = std::move(leaf->left);
-            leaf->left.release();
-            leaf->left = std::move(leaf->right);
-        }
-        n.release();
-    }
-
   public:
     STree() = default;
 
+    explicit STree(Compare c) : BSTree<value_type, Compare>(c), compare(std::move(c)) {}
+
     ~STree() {
-        release_subtree(std::move(m_root));
+        m_nodes.release_tree(std::move(m_root));
+    }
+
+    // as BSTree's
+    STree(STree&& other) noexcept
+        : BSTree<value_type, Compare>(other.compare),
+          m_nodes(std::move(other.m_nodes)),
+          m_root(std::move(other.m_root)),
+          m_size(std::exchange(other.m_size, 0)),
+          compare(other.compare) {}
+
+    STree& operator=(STree&& other) noexcept {
+        m_nodes.swap(other.m_nodes);
+        std::swap(m_root, other.m_root);
+        std::swap(m_size, other.m_size);
+        std::swap(compare, other.compare);
+        return *this;
     }
 
     STree(std::initializer_list<value_type> vals) {
@@ -178,28 +190,31 @@ template <typename value_type> class STree : private BSTree<value_type> {
 
     size_t size() { return m_size; }
     bool empty() { return m_size == 0; }
-    void clear() { m_root.release(); }
+    void clear() {
+        m_nodes.release_tree(std::move(m_root));
+        m_nodes.clear();
+        m_size = 0;
+    }
 
     void insert(const value_type &val) {
         raw_ptr parent = nullptr;
         auto node = m_root.get();
+        bool left = false;
 
         while (node != nullptr) {
             parent = node;
-            if (val < node->val)
-                node = node->left.get();
-            else
-                node = node->right.get();
+            left = compare(val, node->val) < 0;
+            node = left ? node->left.get() : node->right.get();
         }
 
         if (parent == nullptr) {
-            m_root = std::make_unique<Node>(val);
-        } else if (val < parent->val) {
-            parent->left = std::make_unique<Node>(val);
+            m_root = m_nodes.make(val);
+        } else if (left) {
+            parent->left = m_nodes.make(val);
             parent->left->parent = parent;
             rebalance(parent->left.get());
         } else {
-            parent->right = std::make_unique<Node>(val);
+            parent->right = m_nodes.make(val);
             parent->right->parent = parent;
             rebalance(parent->right.get());
         }
@@ -210,12 +225,12 @@ template <typename value_type> class STree : private BSTree<value_type> {
     bool contains(const value_type &val) {
         raw_ptr node = m_root.get();
         raw_ptr parent = nullptr;
-        while (node != nullptr && val != node->val) {
+        while (node != nullptr) {
+            int c = compare(val, node->val);
+            if (c == 0)
+                break;
             parent = node;
-            if (val < node->val)
-                node = node->left.get();
-            else
-                node = node->right.get();
+            node = c < 0 ? node->left.get() : node->right.get();
         }
         if (node == nullptr) {
             rebalance(parent);
@@ -1,5 +1,19 @@
 #include <catch.hpp>
 #include <bloom_filter.hpp>
+#include <blocked_bloom_filter.hpp>
+#include <concurrent_bloom_filter.hpp>
+#include <counting_bloom_filter.hpp>
+#include <scalable_bloom_filter.hpp>
+#include <parallel_bloom_filter.hpp>
+#include <partitioned_bloom_filter.hpp>
+#include <sliding_bloom_filter.hpp>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <type_traits>
 
 TEST_CASE("Bloom filter", "[data-structure]") {
     SECTION("1 in 2") {
@@ -34,4 +48,424 @@ TEST_CASE("Bloom filter", "[data-structure]") {
         CHECK(bf.test("yes")   == false);
     }
 
-}
\ No newline at end of file
+    SECTION("optimal shape") {
+        auto [m, k] = bloom_filter<std::string>::optimal_shape(1000, 0.01);
+        CHECK(m == 9586);
+        CHECK(k == 7);
+        CHECK(counting_bloom_filter<std::string>(1000, 0.01).get_bit_count() == m);
+        CHECK(concurrent_bloom_filter<std::string>(1000, 0.01).get_bit_count() == m);
+
+        CHECK_THROWS_AS(bloom_filter<std::string>::optimal_shape(0, 0.01), std::invalid_argument);
+        CHECK_THROWS_AS(bloom_filter<std::string>::optimal_shape(1000, 0), std::invalid_argument);
+        CHECK_THROWS_AS(bloom_filter<std::string>::optimal_shape(1000, 1), std::invalid_argument);
+        CHECK_THROWS_AS(counting_bloom_filter<std::string>(1000, -1), std::invalid_argument);
+    }
+
+    SECTION("explicit shape") {
+        auto bf = bloom_filter<std::string>::with_shape(6000, 3);
+        CHECK(bf.get_bit_count() == 6000);
+        CHECK(bf.get_hash_func_count() == 3);
+
+        bf.add({"hello", "world"});
+        CHECK(bf.test("hello") == true);
+        CHECK(bf.test("world") == true);
+        CHECK(bf.test("not")   == false);
+
+        // 32 bit hashes cannot reach past bit 2^32
+        CHECK_THROWS_AS(bloom_filter<std::string>::with_shape((uint64_t(1) << 32) + 1, 3),
+                        std::invalid_argument);
+        CHECK_THROWS_AS(bloom_filter<std::string>(1000000000, 0.0001), std::invalid_argument);
+
+        // degenerate shapes would divide by zero or pass every key
+        CHECK_THROWS_AS(bloom_filter<std::string>::with_shape(0, 3), std::invalid_argument);
+        CHECK_THROWS_AS(bloom_filter<std::string>::with_shape(6000, 0), std::invalid_argument);
+        CHECK_THROWS_AS(bloom_filter<std::string>::with_shape(6000, 1000), std::invalid_argument);
+        CHECK_THROWS_AS(bloom_filter<std::string>(0, 0.01), std::invalid_argument);
+        CHECK_THROWS_AS(bloom_filter<std::string>(1000, 0), std::invalid_argument);
+        CHECK_THROWS_AS(bloom_filter<std::string>(1000, 1.5), std::invalid_argument);
+        CHECK(bloom_filter<std::string, XXH3Hasher<std::string>>::max_bit_count > (uint64_t(1) << 32));
+    }
+
+    SECTION("huge pages") {
+        bloom_filter<uint64_t, XXH3Hasher<uint64_t>> bf(100000, 0.01, bit_storage::huge_pages);
+        for (uint64_t i = 0; i < 100000; ++i)
+            bf.add(i);
+
+        bool all = true;
+        for (uint64_t i = 0; i < 100000; ++i)
+            all = all && bf.test(i);
+        CHECK(all == true);
+
+        auto copy = bf;
+        CHECK(copy.test(uint64_t(42)) == true);
+    }
+
+    SECTION("xxhash3 policy") {
+        bloom_filter<std::string, XXH3Hasher<std::string>> bf(100, 0.01);
+        bf.add({"hello", "world", "foo", "bar"});
+
+        CHECK(bf.get_bit_count() == 959);
+        CHECK(bf.get_hash_func_count() == 7);
+
+        CHECK(bf.test("hello") == true);
+        CHECK(bf.test("world") == true);
+        CHECK(bf.test("foo")   == true);
+        CHECK(bf.test("bar")   == true);
+
+        int false_positives = 0;
+        for (int i = 0; i < 10000; ++i)
+            false_positives += bf.test(std::to_string(i));
+        CHECK(false_positives < 10);
+    }
+
+    SECTION("string views") {
+        bloom_filter<std::string> bf(100, 0.01);
+        std::string buffer = "GET /hello HTTP/1.1";
+        bf.add(std::string_view(buffer).substr(5, 5));
+        bf.add(buffer.data() + 11, 4);
+        bf.add("foo");
+
+        CHECK(bf.test("hello") == true);
+        CHECK(bf.test(std::string("HTTP")) == true);
+        CHECK(bf.test(std::string_view("foo")) == true);
+        CHECK(bf.test(buffer.data() + 4, 6) == false);
+        CHECK(bf.test("not") == false);
+    }
+
+    SECTION("introspection") {
+        bloom_filter<std::string> bf(1000, 0.01);
+        CHECK(bf.count_set_bits() == 0);
+        CHECK(bf.estimate_cardinality() == 0);
+
+        for (int i = 0; i < 1000; ++i)
+            bf.add(std::to_string(i));
+
+        // 1 - e^(-kn/m) with k = 7, n = 1000 and m = 9586
+        CHECK(bf.get_fill_ratio() == Approx(0.518).epsilon(0.05));
+        CHECK(bf.estimate_cardinality() == Approx(1000).epsilon(0.05));
+        CHECK(bf.estimate_fp_rate() == Approx(0.01).epsilon(0.3));
+
+        CHECK(bf.get_add_count() == 1000);
+        bf.test("hello");
+        bf.test("0");
+        CHECK(bf.get_test_count() == 2);
+        CHECK(bf.get_positive_count() == 1);
+
+        std::vector<std::thread> testers;
+        for (int t = 0; t < 4; ++t)
+            testers.emplace_back([&bf]() {
+                for (int i = 0; i < 1000; ++i)
+                    bf.test(std::to_string(i));
+            });
+        for (auto& tester : testers)
+            tester.join();
+        CHECK(bf.get_test_count() == 4002);
+        CHECK(bf.get_positive_count() == 4001);
+
+        bloom_filter<std::string> other(1000, 0.01);
+        other.add("hello");
+        other.test("hello");
+        REQUIRE(bf.merge_union(other) == true);
+        CHECK(bf.get_add_count() == 1001);
+        // stages of a scalable_bloom_filter move rather than copy on growth
+        static_assert(std::is_nothrow_move_constructible_v<bloom_filter<std::string>>);
+        CHECK(bf.get_test_count() == 4003);
+        CHECK(bf.get_positive_count() == 4002);
+    }
+
+    SECTION("batched") {
+        bloom_filter<std::string> bf(100, 0.01);
+        std::vector<std::string> keys = {"hello", "world", "foo", "bar"};
+        bf.add_many(keys.begin(), keys.end());
+
+        for (auto& key : keys)
+            CHECK(bf.test(key) == true);
+
+        std::vector<std::string> queries = {"hello", "not", "bar", "yes"};
+        auto found = bf.test_many(queries.begin(), queries.end());
+        CHECK(found == std::vector<bool>{true, false, true, false});
+    }
+
+    SECTION("mapped") {
+        bloom_filter<std::string> bf(100, 0.01);
+        bf.add({"hello", "world", "foo", "bar"});
+        CHECK(bf.save("bf_tests.bloom") == true);
+
+        auto mapped = bloom_filter<std::string>::open_mapped("bf_tests.bloom");
+        std::remove("bf_tests.bloom");
+        REQUIRE(mapped.has_value());
+        CHECK(mapped->is_mapped() == true);
+        CHECK(mapped->get_bit_count() == 959);
+        CHECK(mapped->get_hash_func_count() == 7);
+
+        CHECK(mapped->test("hello") == true);
+        CHECK(mapped->test("bar")   == true);
+        CHECK(mapped->test("not")   == false);
+
+        mapped->add("not");
+        CHECK(mapped->test("not") == true);
+
+        CHECK(bloom_filter<std::string>::open_mapped("missing.bloom").has_value() == false);
+    }
+
+    SECTION("mapped with a bad shape") {
+        bloom_filter<std::string> bf(100, 0.01);
+        for (auto [m, k] : {std::pair<uint64_t, uint64_t>{959, 0}, {959, 1000}, {0, 7}}) {
+            CHECK(bf.save("bf_tests.bloom") == true);
+            std::fstream fs("bf_tests.bloom", std::ios::binary | std::ios::in | std::ios::out);
+            fs.seekp(offsetof(bloom_filter_header, bit_count));
+            fs.write(reinterpret_cast<const char*>(&m), sizeof(m));
+            fs.write(reinterpret_cast<const char*>(&k), sizeof(k));
+            uint64_t words = (m + 63) / 64;
+            fs.write(reinterpret_cast<const char*>(&words), sizeof(words));
+            fs.close();
+
+            CHECK(bloom_filter<std::string>::open_mapped("bf_tests.bloom").has_value() == false);
+        }
+        std::remove("bf_tests.bloom");
+    }
+
+    SECTION("compressed") {
+        bloom_filter<std::string> sparse(1000, 0.01);
+        sparse.add({"hello", "world", "foo", "bar"});
+        bloom_filter<std::string> full(1000, 0.01);
+        for (int i = 0; i < 1000; ++i)
+            full.add(std::to_string(i));
+
+        for (auto* bf : {&sparse, &full}) {
+            std::stringstream ss;
+            CHECK(bf->save_compressed(ss) == true);
+            auto copy = bloom_filter<std::string>::load_compressed(ss);
+            REQUIRE(copy.has_value());
+            CHECK(copy->get_bit_count() == bf->get_bit_count());
+            CHECK(copy->get_hash_func_count() == bf->get_hash_func_count());
+            CHECK(copy->count_set_bits() == bf->count_set_bits());
+            CHECK(copy->test("hello") == bf->test("hello"));
+            CHECK(copy->test("not") == bf->test("not"));
+        }
+
+        std::stringstream ss;
+        sparse.save_compressed(ss);
+        // 56 byte header and ~300 bits of codes for 28 set bits
+        CHECK(ss.str().size() <= 56 + 40);
+
+        std::stringstream truncated(ss.str().substr(0, 70));
+        CHECK(bloom_filter<std::string>::load_compressed(truncated).has_value() == false);
+
+        // filters sent back to back come out one at a time
+        std::stringstream stream;
+        for (auto* bf : {&sparse, &full, &sparse})
+            CHECK(bf->save_compressed(stream) == true);
+        for (auto* bf : {&sparse, &full, &sparse}) {
+            auto copy = bloom_filter<std::string>::load_compressed(stream);
+            REQUIRE(copy.has_value());
+            CHECK(copy->count_set_bits() == bf->count_set_bits());
+            CHECK(copy->test("hello") == bf->test("hello"));
+        }
+        CHECK(stream.peek() == EOF);
+
+        // raw words must hold exactly the set bits the header counts, bits
+        // past the end are dropped
+        std::stringstream raw;
+        full.save_compressed(raw);
+        std::string words = raw.str();
+        REQUIRE(words.size() == sizeof(bloom_filter_compressed_header) + (9586 + 63) / 64 * 8);
+        words.back() ^= char(0x80);
+        std::stringstream past_end(words);
+        auto masked = bloom_filter<std::string>::load_compressed(past_end);
+        REQUIRE(masked.has_value());
+        CHECK(masked->count_set_bits() == full.count_set_bits());
+        words[sizeof(bloom_filter_compressed_header)] ^= char(0x01);
+        std::stringstream flipped(words);
+        CHECK(bloom_filter<std::string>::load_compressed(flipped).has_value() == false);
+
+        // shapes nobody saved are refused before allocating anything
+        using header_type = bloom_filter_compressed_header;
+        for (auto [m, k] : {std::pair<uint64_t, uint64_t>{0, 7}, {9586, 0}, {9586, 1000},
+                            {uint64_t(1) << 40, 7}}) {
+            std::string bytes = ss.str();
+            std::memcpy(&bytes[offsetof(header_type, bit_count)], &m, sizeof(m));
+            std::memcpy(&bytes[offsetof(header_type, hash_func_count)], &k, sizeof(k));
+            std::stringstream bad(bytes);
+            CHECK(bloom_filter<std::string>::load_compressed(bad).has_value() == false);
+        }
+    }
+
+    SECTION("merge") {
+        bloom_filter<std::string> a(100, 0.01);
+        bloom_filter<std::string> b(100, 0.01);
+        a.add({"hello", "world", "foo"});
+        b.add({"foo", "bar"});
+
+        auto u = a;
+        CHECK(u.merge_union(b) == true);
+        CHECK(u.test("hello") == true);
+        CHECK(u.test("world") == true);
+        CHECK(u.test("foo")   == true);
+        CHECK(u.test("bar")   == true);
+        CHECK(u.test("not")   == false);
+
+        auto i = a;
+        CHECK(i.merge_intersection(b) == true);
+        CHECK(i.test("foo")   == true);
+        CHECK(i.test("hello") == false);
+        CHECK(i.test("bar")   == false);
+
+        bloom_filter<std::string> other(1000, 0.01);
+        CHECK(u.merge_union(other) == false);
+    }
+
+    SECTION("parallel build") {
+        std::vector<std::string> keys;
+        for (int i = 0; i < 1000; ++i)
+            keys.push_back(std::to_string(i));
+
+        auto bf = parallel_build<std::string>(1000, 0.01, keys.begin(), keys.end(), 3);
+        bool all = true;
+        for (auto& key : keys)
+            all = all && bf.test(key);
+        CHECK(all == true);
+        CHECK(bf.get_bit_count() == bloom_filter<std::string>(1000, 0.01).get_bit_count());
+        CHECK(bf.get_add_count() == keys.size());
+    }
+
+}
+
+TEST_CASE("Blocked bloom filter", "[data-structure]") {
+    blocked_bloom_filter<std::string> bf(100, 0.01);
+    bf.add({"hello", "world", "foo", "bar"});
+
+    CHECK(bf.get_block_count() == 2);
+    CHECK(bf.get_bit_count() == 1024);
+    CHECK(bf.get_hash_func_count() == 7);
+
+    CHECK(bf.test("hello") == true);
+    CHECK(bf.test("world") == true);
+    CHECK(bf.test("foo")   == true);
+    CHECK(bf.test("bar")   == true);
+
+    CHECK(bf.get_fp_rate() > bf.get_classic_fp_rate());
+    CHECK(bf.get_fp_rate_overhead() > 0);
+    CHECK(bf.get_fp_rate() < 0.05);
+}
+
+
+TEST_CASE("Concurrent bloom filter", "[data-structure]") {
+    concurrent_bloom_filter<std::string> bf(1000, 0.01);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([&bf, t]() {
+            for (int i = t; i < 1000; i += 4)
+                bf.add(std::to_string(i));
+        });
+    for (auto& thread : threads)
+        thread.join();
+
+    bool all = true;
+    for (int i = 0; i < 1000; ++i)
+        all = all && bf.test(std::to_string(i));
+    CHECK(all == true);
+
+    CHECK(bf.test("hello") == false);
+}
+
+TEST_CASE("Counting bloom filter", "[data-structure]") {
+    counting_bloom_filter<std::string> bf(100, 0.01);
+    bf.add({"hello", "world", "foo", "bar"});
+
+    CHECK(bf.get_bit_count() == 959);
+    CHECK(bf.get_hash_func_count() == 7);
+    CHECK(bf.get_memory_usage() == 60 * 8);
+
+    CHECK(bf.test("hello") == true);
+    CHECK(bf.test("foo")   == true);
+
+    bf.remove("hello");
+    bf.remove("not");
+    CHECK(bf.test("hello") == false);
+    CHECK(bf.test("world") == true);
+    CHECK(bf.test("foo")   == true);
+    CHECK(bf.test("bar")   == true);
+
+    for (int i = 0; i < 20; ++i)
+        bf.add("foo");
+    for (int i = 0; i < 21; ++i)
+        bf.remove("foo");
+    CHECK(bf.test("foo") == true);
+}
+
+TEST_CASE("Scalable bloom filter", "[data-structure]") {
+    scalable_bloom_filter<std::string> bf(100, 0.01);
+    CHECK(bf.get_stage_count() == 1);
+    CHECK_THROWS_AS(scalable_bloom_filter<std::string>(0, 0.01), std::invalid_argument);
+
+    for (int i = 0; i < 1000; ++i)
+        bf.add(std::to_string(i));
+
+    // 100 + 200 + 400 < 1000 <= 100 + 200 + 400 + 800
+    CHECK(bf.get_stage_count() == 4);
+    CHECK(bf.size() <= 1000);
+
+    bool all = true;
+    for (int i = 0; i < 1000; ++i)
+        all = all && bf.test(std::to_string(i));
+    CHECK(all == true);
+
+    int false_positives = 0;
+    for (int i = 1000; i < 11000; ++i)
+        false_positives += bf.test(std::to_string(i));
+    CHECK(false_positives < 200);
+}
+
+TEST_CASE("Sliding bloom filter", "[data-structure]") {
+    sliding_bloom_filter<std::string> bf(300, 0.01, 3);
+    CHECK(bf.get_generation_count() == 3);
+    CHECK_THROWS_AS(sliding_bloom_filter<std::string>(300, 0.01, 0), std::invalid_argument);
+    CHECK_THROWS_AS(sliding_bloom_filter<std::string>(0, 0.01, 3), std::invalid_argument);
+
+    bf.add({"hello", "world"});
+    bf.rotate();
+    bf.add("foo");
+    bf.rotate();
+    bf.add("bar");
+
+    CHECK(bf.test("hello") == true);
+    CHECK(bf.test("foo")   == true);
+    CHECK(bf.test("bar")   == true);
+    CHECK(bf.test("not")   == false);
+
+    bf.rotate();
+    CHECK(bf.test("hello") == false);
+    CHECK(bf.test("world") == false);
+    CHECK(bf.test("foo")   == true);
+    CHECK(bf.test("bar")   == true);
+
+    bf.rotate();
+    bf.rotate();
+    CHECK(bf.test("foo") == false);
+    CHECK(bf.test("bar") == false);
+}
+
+TEST_CASE("Partitioned bloom filter", "[data-structure]") {
+    partitioned_bloom_filter<std::string> bf(1000, 0.01);
+    CHECK(bf.get_hash_func_count() == 7);
+    CHECK(bf.get_slice_bit_count() == 1408);
+    CHECK(bf.get_bit_count() == 7 * 1408);
+
+    for (int i = 0; i < 1000; ++i)
+        bf.add(std::to_string(i));
+
+    bool all = true;
+    for (int i = 0; i < 1000; ++i)
+        all = all && bf.test(std::to_string(i));
+    CHECK(all == true);
+
+    int false_positives = 0;
+    for (int i = 1000; i < 11000; ++i)
+        false_positives += bf.test(std::to_string(i));
+    CHECK(false_positives < 200);
+
+    CHECK_THROWS_AS(partitioned_bloom_filter<std::string>(4000000000, 0.01),
+                    std::invalid_argument);
+}
@@ -0,0 +1,24 @@
+#include <catch.hpp>
+#include <bloom_set.hpp>
+
+TEST_CASE("Bloom fronted set", "[data-structure]") {
+    bloom_set<std::string> s(100, 0.01);
+    CHECK(s.empty() == true);
+
+    for (auto& key : {"hello", "world", "foo", "bar"})
+        s.insert(key);
+    CHECK(s.size() == 4);
+
+    CHECK(s.contains("hello") == true);
+    CHECK(s.contains("bar")   == true);
+    CHECK(s.contains("not")   == false);
+    CHECK(s.contains("yes")   == false);
+
+    CHECK(s.get_lookup_count() == 4);
+    CHECK(s.get_descents_saved() == 2);
+    CHECK(s.get_false_positive_count() == 0);
+    CHECK(s.get_filter_hit_rate() == 0.5);
+
+    s.reset_stats();
+    CHECK(s.get_lookup_count() == 0);
+}
@@ -1,5 +1,7 @@
 #include <catch.hpp>
 #include <bst.hpp>
+#include <st.hpp>
+#include <string>
 
 TEST_CASE("Binary Search Trees", "[data-structure]") {
     SECTION("transform") {
@@ -10,4 +12,55 @@ TEST_CASE("Binary Search Trees", "[data-structure]") {
         CHECK(t.contains(4));
         CHECK(t.contains(6)); 
     }
-}
\ No newline at end of file
+
+    SECTION("remove") {
+        BSTree<std::string> t = {"d", "b", "f", "a", "c", "e", "g"};
+        t.remove("a");
+        t.remove("f");
+        t.remove("d");
+        CHECK(t.size() == 4);
+        CHECK(t.contains("a") == false);
+        CHECK(t.contains("d") == false);
+        CHECK(t.contains("f") == false);
+        CHECK(t.contains("b"));
+        CHECK(t.contains("c"));
+        CHECK(t.contains("e"));
+        CHECK(t.contains("g"));
+
+        // reuses the removed nodes' slots
+        t.insert("a");
+        t.insert("d");
+        CHECK(t.size() == 6);
+        CHECK(t.contains("a"));
+        CHECK(t.contains("d"));
+    }
+
+    SECTION("degenerate") {
+        BSTree<std::string> t;
+        for (int i = 0; i < 10000; ++i)
+            t.insert(std::to_string(1000000 + i));
+        CHECK(t.size() == 10000);
+        t.clear();
+        CHECK(t.empty());
+        t.insert("x");
+        CHECK(t.contains("x"));
+    }
+
+    SECTION("comparator object") {
+        struct modulo {
+            int m;
+            int operator()(int a, int b) const { return (b % m < a % m) - (a % m < b % m); }
+        };
+        BSTree<int, modulo> t(modulo{10});
+        t.insert(3);
+        CHECK(t.contains(13));
+        BSTree<int, modulo> moved = std::move(t);
+        CHECK(moved.contains(23));
+
+        STree<int, modulo> s(modulo{10});
+        s.insert(3);
+        CHECK(s.contains(13));
+        STree<int, modulo> s_moved = std::move(s);
+        CHECK(s_moved.contains(23));
+    }
+}
@@ -0,0 +1,50 @@
+#include <catch.hpp>
+#include <cuckoo_filter.hpp>
+
+TEST_CASE("Cuckoo filter", "[data-structure]") {
+    SECTION("add, test and remove") {
+        cuckoo_filter<std::string> cf(100);
+        cf.add({"hello", "world", "foo", "bar"});
+
+        CHECK(cf.size() == 4);
+        CHECK(cf.get_bucket_count() == 32);
+        CHECK(cf.get_memory_usage() == 32 * 8);
+
+        CHECK(cf.test("hello") == true);
+        CHECK(cf.test("world") == true);
+        CHECK(cf.test("foo")   == true);
+        CHECK(cf.test("bar")   == true);
+        CHECK(cf.test("not")   == false);
+
+        CHECK(cf.remove("hello") == true);
+        CHECK(cf.remove("not")   == false);
+        CHECK(cf.size() == 3);
+        CHECK(cf.test("hello") == false);
+        CHECK(cf.test("world") == true);
+    }
+
+    SECTION("high load") {
+        cuckoo_filter<std::string, 32> cf(10000);
+        size_t added = 0;
+        for (int i = 0; i < 16384 && cf.add(std::to_string(i)); ++i)
+            ++added;
+        CHECK(added > 15000);
+
+        bool all = true;
+        for (size_t i = 0; i < added; ++i)
+            all = all && cf.test(std::to_string(i));
+        CHECK(all == true);
+
+        int false_positives = 0;
+        for (int i = 20000; i < 120000; ++i)
+            false_positives += cf.test(std::to_string(i));
+        CHECK(false_positives == 0);
+
+        for (size_t i = 0; i < added; i += 2)
+            cf.remove(std::to_string(i));
+        all = true;
+        for (size_t i = 1; i < added; i += 2)
+            all = all && cf.test(std::to_string(i));
+        CHECK(all == true);
+    }
+}
@@ -0,0 +1,52 @@
+#include <catch.hpp>
+#include <fuse_filter.hpp>
+
+TEST_CASE("Binary fuse filter", "[data-structure]") {
+    SECTION("small") {
+        fuse_filter<std::string> ff = {"hello", "world", "foo", "bar", "foo"};
+
+        CHECK(ff.size() == 4);
+        CHECK(ff.test("hello") == true);
+        CHECK(ff.test("world") == true);
+        CHECK(ff.test("foo")   == true);
+        CHECK(ff.test("bar")   == true);
+    }
+
+    SECTION("8 bit fingerprints") {
+        std::vector<std::string> keys;
+        for (int i = 0; i < 100000; ++i)
+            keys.push_back(std::to_string(i));
+        fuse_filter<std::string> ff(keys.begin(), keys.end());
+
+        bool all = true;
+        for (auto& key : keys)
+            all = all && ff.test(key);
+        CHECK(all == true);
+
+        CHECK(ff.get_bits_per_key() < 10);
+
+        int false_positives = 0;
+        for (int i = 100000; i < 200000; ++i)
+            false_positives += ff.test(std::to_string(i));
+        // 1/256 of 100000 is ~390
+        CHECK(false_positives > 200);
+        CHECK(false_positives < 600);
+    }
+
+    SECTION("32 bit fingerprints") {
+        std::vector<std::string> keys;
+        for (int i = 0; i < 100000; ++i)
+            keys.push_back(std::to_string(i));
+        fuse_filter<std::string, uint32_t> ff(keys.begin(), keys.end());
+
+        bool all = true;
+        for (auto& key : keys)
+            all = all && ff.test(key);
+        CHECK(all == true);
+
+        int false_positives = 0;
+        for (int i = 100000; i < 200000; ++i)
+            false_positives += ff.test(std::to_string(i));
+        CHECK(false_positives == 0);
+    }
+}
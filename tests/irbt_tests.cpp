@@ -0,0 +1,139 @@
+#include <catch.hpp>
+#include <irbt.hpp>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+TEST_CASE("Index RedBlack Trees", "[data-structure]") {
+
+    using Tree = IndexRBTree<int>;
+
+    SECTION("construction") {
+        Tree e{};
+        CHECK(e.empty() == true);
+        CHECK(e.size() == 0);
+
+        Tree t = {1, 2, 3};
+        CHECK(t.empty() == false);
+        CHECK(t.size() == 3);
+        CHECK(t.contains(2) == true);
+        CHECK(t.contains(4) == false);
+    }
+
+    SECTION("erase") {
+        Tree t;
+        for (int i = 0; i < 1000; ++i)
+            t.insert((i * 7919) % 1000);
+
+        bool erased = true;
+        for (int i = 0; i < 1000; i += 2)
+            erased = erased && t.erase((i * 7919) % 1000) && t.is_valid();
+        CHECK(erased == true);
+        CHECK(t.size() == 500);
+        CHECK(t.erase(1000) == false);
+
+        bool all = true;
+        for (int i = 0; i < 1000; ++i)
+            all = all && t.contains((i * 7919) % 1000) == (i % 2 == 1);
+        CHECK(all == true);
+
+        // erased slots are reused before the node array grows
+        size_t bytes = t.get_memory_usage();
+        for (int i = 0; i < 500; ++i)
+            t.insert(1000 + i);
+        CHECK(t.get_memory_usage() == bytes);
+        CHECK(t.size() == 1000);
+        CHECK(t.is_valid() == true);
+    }
+
+    SECTION("strings") {
+        IndexRBTree<std::string> t;
+        for (int i = 0; i < 1000; ++i)
+            t.insert(std::to_string(i));
+        CHECK(t.contains("999") == true);
+        CHECK(t.erase("999") == true);
+        CHECK(t.contains("999") == false);
+        t.clear();
+        CHECK(t.empty() == true);
+    }
+
+    SECTION("save and load") {
+        Tree t;
+        for (int i = 0; i < 1000; ++i)
+            t.insert((i * 7919) % 1000);
+        for (int i = 0; i < 1000; i += 3)
+            t.erase(i);
+
+        std::stringstream ss;
+        CHECK(t.save(ss) == true);
+        auto loaded = Tree::load(ss);
+        REQUIRE(loaded.has_value());
+        CHECK(loaded->size() == t.size());
+        CHECK(loaded->is_valid() == true);
+
+        bool same = true;
+        for (int i = 0; i < 1000; ++i)
+            same = same && loaded->contains(i) == (i % 3 != 0);
+        CHECK(same == true);
+
+        loaded->insert(3);
+        CHECK(loaded->contains(3) == true);
+
+        std::stringstream garbage("not a tree");
+        CHECK(Tree::load(garbage).has_value() == false);
+
+        // nodes sit right after the 40 byte header, as val, left, right
+        // and parent words
+        std::string bytes = ss.str();
+        auto corrupt = [&](size_t node, size_t field, uint32_t value) {
+            std::string copy = bytes;
+            std::memcpy(&copy[sizeof(index_rbtree_header) + node * Tree::node_size
+                              + field * sizeof(uint32_t)], &value, sizeof(value));
+            std::stringstream in(copy);
+            return Tree::load(in).has_value() == false;
+        };
+        CHECK(corrupt(5, 1, 100000) == true);
+        CHECK(corrupt(5, 2, 5) == true);
+        CHECK(corrupt(5, 3, 0) == true);
+        // a red sentinel with a parent far out of the array
+        CHECK(corrupt(0, 3, 0xfffffff0) == true);
+        CHECK(corrupt(0, 1, 5) == true);
+
+        // a red root, keeping its parent link
+        uint32_t root;
+        std::memcpy(&root, &bytes[offsetof(index_rbtree_header, root)], sizeof(root));
+        CHECK(corrupt(root, 3, uint32_t(1) << 31) == true);
+        // values out of order
+        CHECK(corrupt(root, 0, 100000) == true);
+
+        std::string oversized = bytes;
+        uint64_t size = t.size() + 1;
+        std::memcpy(&oversized[offsetof(index_rbtree_header, size)], &size, sizeof(size));
+        std::stringstream in(oversized);
+        CHECK(Tree::load(in).has_value() == false);
+
+        // a header claiming 2^31 nodes and no nodes after it
+        std::string claims = bytes.substr(0, sizeof(index_rbtree_header));
+        uint64_t node_count = uint64_t(1) << 31;
+        std::memcpy(&claims[offsetof(index_rbtree_header, node_count)], &node_count, sizeof(node_count));
+        std::stringstream short_stream(claims);
+        CHECK(Tree::load(short_stream).has_value() == false);
+    }
+
+    SECTION("comparator object") {
+        struct modulo {
+            int m;
+            int operator()(int a, int b) const { return (b % m < a % m) - (a % m < b % m); }
+        };
+        IndexRBTree<int, modulo> t(modulo{10});
+        t.insert(3);
+        CHECK(t.contains(13) == true);
+
+        std::stringstream ss;
+        CHECK(t.save(ss) == true);
+        auto loaded = IndexRBTree<int, modulo>::load(ss, modulo{10});
+        REQUIRE(loaded.has_value());
+        CHECK(loaded->contains(23) == true);
+    }
+}
@@ -1,5 +1,10 @@
 #include <catch.hpp>
 #include <rbt.hpp>
+#include <cstdlib>
+#include <iterator>
+#include <numeric>
+#include <string>
+#include <vector>
 
 TEST_CASE("RedBlack Trees", "[data-structure]") {
 
@@ -36,4 +41,225 @@ TEST_CASE("RedBlack Trees", "[data-structure]") {
         CHECK(Tree{1, 2, 3} != Tree{});
         CHECK(Tree{1, 2, 3} != Tree{3, 2, 1});
     }
-}
\ No newline at end of file
+
+    SECTION("unordered insertion") {
+        Tree t;
+        for (int i = 0; i < 1000; ++i)
+            t.insert((i * 7919) % 1000);
+        CHECK(t.size() == 1000);
+        CHECK(t.is_valid() == true);
+
+        bool all = true;
+        for (int i = 0; i < 1000; ++i)
+            all = all && t.contains(i);
+        CHECK(all == true);
+        CHECK(t.contains(1000) == false);
+    }
+
+    SECTION("node storage") {
+        RBTree<std::string> t;
+        for (int i = 0; i < 1000; ++i)
+            t.insert(std::to_string(i));
+        CHECK(t.get_memory_usage() > 0);
+
+        auto moved = std::move(t);
+        CHECK(moved.size() == 1000);
+        CHECK(moved.contains("999"));
+
+        moved.clear();
+        CHECK(moved.get_memory_usage() == 0);
+        moved.insert("a");
+        CHECK(moved.contains("a"));
+    }
+
+    SECTION("erase") {
+        Tree t;
+        for (int i = 0; i < 1000; ++i)
+            t.insert((i * 7919) % 1000);
+
+        bool erased = true;
+        for (int i = 0; i < 1000; i += 2)
+            erased = erased && t.erase((i * 7919) % 1000) && t.is_valid();
+        CHECK(erased == true);
+        CHECK(t.size() == 500);
+        CHECK(t.erase(1000) == false);
+
+        bool all = true;
+        for (int i = 0; i < 1000; ++i)
+            all = all && t.contains((i * 7919) % 1000) == (i % 2 == 1);
+        CHECK(all == true);
+
+        t = Tree{1, 2, 2, 3};
+        CHECK(t.erase(2) == true);
+        CHECK(t.contains(2) == true);
+        CHECK(t.erase(2) == true);
+        CHECK(t.contains(2) == false);
+        CHECK(t.size() == 2);
+        CHECK(t.is_valid() == true);
+
+        // erasing a node with two children moves no other value
+        Tree u;
+        for (int i = 0; i < 100; ++i)
+            u.insert(i);
+        std::vector<Tree::iterator> its;
+        for (auto it = u.begin(); it != u.end(); ++it)
+            its.push_back(it);
+        bool next = true;
+        for (int i = 0; i < 100; i += 3)
+            next = next && u.erase(its[i]) == (i + 1 < 100 ? its[i + 1] : u.end())
+                        && u.is_valid();
+        CHECK(next == true);
+
+        bool kept = true;
+        for (int i = 0; i < 100; ++i)
+            if (i % 3 != 0)
+                kept = kept && *its[i] == i;
+        CHECK(kept == true);
+        CHECK(u.size() == 66);
+    }
+
+    SECTION("iteration") {
+        Tree t;
+        for (int i = 0; i < 100; ++i)
+            t.insert((i * 37) % 100);
+
+        std::vector<int> in_order(t.begin(), t.end());
+        std::vector<int> expected(100);
+        std::iota(expected.begin(), expected.end(), 0);
+        CHECK(in_order == expected);
+
+        // erase every odd value through iterators
+        for (auto it = t.begin(); it != t.end();)
+            if (*it % 2 == 1) it = t.erase(it);
+            else              ++it;
+        CHECK(t.size() == 50);
+        CHECK(t.is_valid() == true);
+        CHECK(*t.begin() == 0);
+        CHECK(t.find(7) == t.end());
+        CHECK(*t.find(8) == 8);
+    }
+
+    SECTION("custom comparator") {
+        struct descending {
+            int operator()(int a, int b) const { return (a < b) - (b < a); }
+        };
+        RBTree<int, descending> t;
+        for (int i = 0; i < 10; ++i)
+            t.insert(i);
+        CHECK(t.contains(3) == true);
+        CHECK(t.contains(10) == false);
+
+        std::vector<int> in_order(t.begin(), t.end());
+        CHECK(in_order == std::vector<int>{9, 8, 7, 6, 5, 4, 3, 2, 1, 0});
+    }
+
+    SECTION("comparator object") {
+        // a capturing lambda has no default constructor
+        int pivot = 50;
+        auto by_distance = [pivot](int a, int b) {
+            int da = std::abs(a - pivot), db = std::abs(b - pivot);
+            return (db < da) - (da < db);
+        };
+        RBTree<int, decltype(by_distance)> t(by_distance);
+        for (int i : {50, 40, 65, 52})
+            t.insert(i);
+        CHECK(std::vector<int>(t.begin(), t.end()) == std::vector<int>{50, 52, 40, 65});
+
+        auto moved = std::move(t);
+        moved.insert(80);
+        CHECK(std::vector<int>(moved.begin(), moved.end()) == std::vector<int>{50, 52, 40, 65, 80});
+        CHECK(t.empty() == true);
+        t.insert(49);
+        t.insert(60);
+        CHECK(std::vector<int>(t.begin(), t.end()) == std::vector<int>{49, 60});
+
+        // move assignment takes the comparator along with the nodes
+        struct modulo {
+            int m = 10;
+            int operator()(int a, int b) const { return (b % m < a % m) - (a % m < b % m); }
+        };
+        RBTree<int, modulo> ten;
+        RBTree<int, modulo> three(modulo{3});
+        three.insert(5);
+        ten = std::move(three);
+        CHECK(ten.contains(2) == true);
+        CHECK(ten.contains(5 + 10) == false);
+    }
+
+    SECTION("assign sorted") {
+        for (unsigned threads : {1u, 4u})
+            for (int n : {0, 1, 2, 7, 100, 50000}) {
+                std::vector<int> sorted(n);
+                std::iota(sorted.begin(), sorted.end(), 0);
+
+                Tree t = {-1, -2};
+                t.assign_sorted(sorted.begin(), sorted.end(), threads);
+                CHECK(t.size() == size_t(n));
+                CHECK(t.contains(-1) == false);
+                CHECK(std::vector<int>(t.begin(), t.end()) == sorted);
+                CHECK(t.is_valid() == true);
+
+                // the coloring holds up under further updates
+                for (int i = 0; i < n; i += 2)
+                    t.erase(i);
+                for (int i = n; i < n + 100; ++i)
+                    t.insert(i);
+                bool all = true;
+                for (int i = 0; i < n + 100; ++i)
+                    all = all && t.contains(i) == (i >= n || i % 2 == 1);
+                CHECK(all == true);
+                CHECK(t.is_valid() == true);
+            }
+    }
+
+    SECTION("range queries") {
+        Tree t;
+        for (int i = 0; i < 100; ++i)
+            t.insert((i * 37) % 100 * 2);
+        t.insert(50);
+        t.insert(50);
+
+        CHECK(*t.lower_bound(50) == 50);
+        CHECK(*t.upper_bound(50) == 52);
+        CHECK(*t.lower_bound(51) == 52);
+        CHECK(*t.upper_bound(51) == 52);
+        CHECK(*t.lower_bound(-5) == 0);
+        CHECK(t.lower_bound(199) == t.end());
+        CHECK(t.upper_bound(198) == t.end());
+
+        auto [first, last] = t.equal_range(50);
+        CHECK(std::distance(first, last) == 3);
+        auto [none, none_end] = t.equal_range(51);
+        CHECK(none == none_end);
+
+        CHECK(t.count_range(0, 200) == 102);
+        CHECK(t.count_range(10, 20) == 5);
+        CHECK(t.count_range(50, 51) == 3);
+        CHECK(t.count_range(20, 10) == 0);
+        CHECK(t.count_range(500, 600) == 0);
+    }
+
+    SECTION("bidirectional iteration") {
+        Tree t;
+        for (int i = 0; i < 100; ++i)
+            t.insert((i * 37) % 100);
+
+        auto it = t.end();
+        --it;
+        CHECK(*it == 99);
+        --it;
+        CHECK(*it-- == 98);
+        CHECK(*it == 97);
+        ++it;
+        CHECK(*it == 98);
+
+        std::vector<int> reversed(t.rbegin(), t.rend());
+        std::vector<int> expected(100);
+        std::iota(expected.rbegin(), expected.rend(), 0);
+        CHECK(reversed == expected);
+
+        it = t.lower_bound(40);
+        CHECK(*std::prev(it) == 39);
+        CHECK(*std::next(it, 10) == 50);
+    }
+}